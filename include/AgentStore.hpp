@@ -0,0 +1,66 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Agent.hpp"
+
+// Magazyn agentów w układzie "structure of arrays", indeksowany numerem komórki (y * width + x).
+// Każda cecha leży w osobnej, ciągłej tablicy, a pamięć relacji to slab ID partnerów
+// [komórki × MaxNeighbors] plus dwie spakowane bitowo plansze akcji (bit i = slot i, 1 = Defect),
+// więc dostęp do sąsiada to zwykły odczyt z tablicy zamiast skoku po wskaźniku.
+class AgentStore {
+public:
+    static constexpr int MaxNeighbors = 8; // stały krok slabu (Moore)
+
+    std::vector<uint8_t> alive;          // 1 = komórka zajęta przez agenta
+    std::vector<int> id;                 // unikalne ID (do wykrywania zmiany sąsiada)
+    std::vector<AgentType> type;         // stała cecha (ewoluuje w reprodukcji)
+    std::vector<Action> currentAction;   // akcja w aktualnej rundzie
+    std::vector<Action> lastAction;      // akcja w poprzedniej rundzie
+    std::vector<Action> visualAction;    // dominująca akcja (do rysowania)
+    std::vector<float> payoff;           // payoff sumowany przez K rund, potem uśredniany
+    std::vector<float> lastPayoff;       // payoff z poprzedniej rundy
+    std::vector<float> reputation;       // reputacja globalna (0..1)
+    std::vector<int> strategyAge;
+    std::vector<uint8_t> memorySize;     // ile slotów pamięci jest w użyciu (4 lub 8, mniej przy Absorbing)
+    std::vector<int32_t> partnerId;      // slab [komórki × MaxNeighbors]: ID sąsiada w slocie (-1 = brak relacji)
+    std::vector<uint8_t> myLastBits;     // co ja zagrałem ostatnio wobec slotu i
+    std::vector<uint8_t> theirLastBits;  // co on zagrał ostatnio wobec mnie
+
+    int nextId = 0; // licznik ID (osobny dla każdej symulacji)
+
+    // Bitset zmienionych komórek (bit idx % 64 w słowie idx / 64): narodziny, śmierć, ruch, zmiana
+    // typu albo visualAction, czyli wszystko, co zmienia wygląd planszy. Silnik tylko ustawia bity;
+    // czyści je odbiorca (SimulationController po skopiowaniu do migawki).
+    std::vector<uint64_t> changed;
+
+    int size() const { return (int)alive.size(); }
+
+    // Ustawia liczbę komórek, usuwa wszystkich agentów i zeruje licznik ID
+    void resize(int cells);
+
+    bool occupied(int idx) const { return alive[idx] != 0; }
+
+    int32_t* partnersOf(int idx) { return partnerId.data() + (size_t)idx * MaxNeighbors; }
+    const int32_t* partnersOf(int idx) const { return partnerId.data() + (size_t)idx * MaxNeighbors; }
+
+    // Tworzy nowego agenta (nowe ID, neutralna reputacja, czysta pamięć) w pustej komórce
+    void spawn(int idx, AgentType t, int neighborsCount);
+
+    // Jak spawn, ale z ID nadanym z zewnątrz (równoległe narodziny nadają ID osobnym przejściem)
+    void spawnWithId(int idx, AgentType t, int neighborsCount, int newId);
+
+    // Usuwa agenta z komórki
+    void kill(int idx);
+
+    // Przenosi agenta (wszystkie cechy + pamięć) do pustej komórki `to`
+    void move(int from, int to);
+
+    // Oznacza komórkę jako zmienioną; bezpieczne przy równoległych wywołaniach
+    void markChanged(int idx);
+    void markAllChanged();
+    void clearChanged();
+
+    // Resetuje pamięć relacji (np. przy narodzinach lub zmianie strategii)
+    void resetMemory(int idx, int neighborsCount);
+};
@@ -0,0 +1,13 @@
+﻿#pragma once
+#include <cstdint>
+
+// Licznik alokacji sterty (diagnostyka, tylko z SOCIALEVO_COUNT_ALLOCATIONS).
+// Podmienia globalny operator new i liczy wywołania w bieżącym wątku,
+// żeby alokacje GUI w innym wątku nie zaburzały pomiaru pokolenia.
+namespace AllocationCounter {
+    uint64_t threadCount();
+
+    // Suma liczników wątku wołającego i wątków jego zespołu OpenMP, czyli wszystkich,
+    // które wykonują regiony równoległe step(). Wołać poza regionem równoległym.
+    uint64_t teamCount();
+}
@@ -0,0 +1,26 @@
+﻿#pragma once
+#include "Simulation.hpp"
+#include <cstdint>
+#include <string>
+
+// Punkt kontrolny: pełny stan symulacji (parametry, siatka, wszystkie tablice agentów z pamięcią
+// relacji, licznik ID, pokolenie, ziarno, historia metryk) w wersjonowanym pliku binarnym.
+//
+// Układ pliku (little-endian): nagłówek, potem sekcje { tag, rozmiar elementu, liczba elementów,
+// dane wyrównane do 8 bajtów }. Tablice leżą w pliku dokładnie tak jak w pamięci, więc odczyt
+// to mapowanie pliku (mmap na POSIX) i kopie blokowe. Stan generatora to (seed, generation),
+// bo generator licznikowy nie ma innego stanu.
+// Ustawienia eksportu CSV, timery i ślad nie są częścią stanu.
+namespace Checkpoint {
+
+    static constexpr uint32_t VERSION = 1;
+
+    // Domyślna nazwa pliku (GUI)
+    static constexpr const char* DEFAULT_PATH = "checkpoint.sevo";
+
+    // Zapis przez plik tymczasowy i podmianę, więc przerwany zapis nie psuje poprzedniego punktu
+    bool save(const Simulation& sim, const std::string& path, std::string& error);
+
+    // Odtwarza stan; przy błędzie (zły plik, inna wersja, niespójne rozmiary) sim zostaje bez zmian
+    bool load(Simulation& sim, const std::string& path, std::string& error);
+}
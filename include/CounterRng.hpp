@@ -0,0 +1,73 @@
+﻿#pragma once
+#include <cstdint>
+
+// Fazy pokolenia, w których losujemy (część klucza licznika)
+enum class RngPhase : uint32_t {
+    Placement,     // rozmieszczenie populacji w reset()
+    MovementOrder, // kolejność ruchu
+    Movement,
+    Death,
+    Birth,
+    Imitation
+};
+
+// Bezstanowy generator licznikowy Philox4x32-10 (Salmon i in., "Parallel Random Numbers: As Easy as 1, 2, 3").
+// Strumień komórki jest wyznaczony przez (seed, generation, cell, phase), więc dowolny wątek może
+// losować dla dowolnej komórki niezależnie, a wynik nie zależy od liczby wątków ani kolejności.
+class CellRng {
+public:
+    CellRng(uint64_t seed, uint32_t generation, uint32_t cell, RngPhase phase)
+        : key{ (uint32_t)seed, (uint32_t)(seed >> 32) },
+          counter{ cell, generation, (uint32_t)phase, 0 } {}
+
+    // Kolejne 32 losowe bity strumienia
+    uint32_t next() {
+        if (used == 4) {
+            philox(counter, key, block);
+            counter[3]++;
+            used = 0;
+        }
+        return block[used++];
+    }
+
+    // Liczba z przedziału [0, 1) (24 bity mantysy)
+    float uniform() {
+        return (float)(next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Liczba całkowita z przedziału [0, n) (mnożenie Lemire'a)
+    int below(int n) {
+        return (int)(((uint64_t)next() * (uint64_t)n) >> 32);
+    }
+
+private:
+    uint32_t key[2];
+    uint32_t counter[4];
+    uint32_t block[4] = {};
+    int used = 4;
+
+    static void mulhilo(uint32_t a, uint32_t b, uint32_t& hi, uint32_t& lo) {
+        uint64_t p = (uint64_t)a * b;
+        hi = (uint32_t)(p >> 32);
+        lo = (uint32_t)p;
+    }
+
+    static void philox(const uint32_t ctr[4], const uint32_t k[2], uint32_t out[4]) {
+        uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+        uint32_t k0 = k[0], k1 = k[1];
+
+        for (int round = 0; round < 10; ++round) {
+            uint32_t hi0, lo0, hi1, lo1;
+            mulhilo(0xD2511F53u, c0, hi0, lo0);
+            mulhilo(0xCD9E8D57u, c2, hi1, lo1);
+            c0 = hi1 ^ c1 ^ k0;
+            c1 = lo1;
+            c2 = hi0 ^ c3 ^ k1;
+            c3 = lo0;
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+
+        out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+    }
+};
@@ -0,0 +1,39 @@
+﻿#pragma once
+#include <bit>
+#include <cstdint>
+
+// Szybkie funkcje matematyczne pisane bez rozgałęzień, żeby pętle z `#pragma omp simd`
+// mogły je zwektoryzować (std::exp blokuje wektoryzację w GCC/MSVC bez -ffast-math).
+namespace FastMath {
+
+    // Zakres argumentu, w którym expApprox jest poprawne (wynik mieści się w normalnym floacie)
+    inline float clampExpArg(float x) {
+        x = x < 88.0f ? x : 88.0f;
+        return x > -87.0f ? x : -87.0f;
+    }
+
+    // exp(x) dla float: redukcja x = n*ln2 + r, wielomian Cephes na r, 2^n przez wykładnik.
+    // Błąd względny ~1e-7. Argument musi być już w [-87, 88] (clampExpArg) - obcinanie
+    // wewnątrz pętli wektorowej GCC zamienia na skoki i rezygnuje z wektoryzacji.
+    inline float expApprox(float x) {
+        // n = round(x / ln2): dodanie 1.5 * 2^23 zaokrągla do całkowitej bez rozgałęzień
+        float fn = (x * 1.44269504088896341f + 12582912.0f) - 12582912.0f;
+        int32_t n = (int32_t)fn;
+
+        // r = x - n*ln2 (ln2 rozbite na dwie części dla dokładności)
+        float r = x - fn * 0.693359375f;
+        r = r - fn * -2.12194440e-4f;
+
+        float p = 1.9875691500E-4f;
+        p = p * r + 1.3981999507E-3f;
+        p = p * r + 8.3334519073E-3f;
+        p = p * r + 4.1665795894E-2f;
+        p = p * r + 1.6666665459E-1f;
+        p = p * r + 5.0000001201E-1f;
+        p = p * r * r + r + 1.0f;
+
+        // 2^n złożone bezpośrednio w bitach wykładnika
+        float pow2n = std::bit_cast<float>((uint32_t)(n + 127) << 23);
+        return p * pow2n;
+    }
+}
@@ -1,6 +1,8 @@
 ﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
 #include <vector>
-#include "Agent.hpp"
 
 enum class BoundaryMode {
     Periodic,
@@ -22,20 +24,49 @@ public:
     BoundaryMode boundary = BoundaryMode::Periodic;
     NeighborhoodType neighborhood = NeighborhoodType::Moore;
 
-    std::vector<Agent*> agents;
-
     Grid(int w, int h);
 
-    Agent*& get(int x, int y);
-    const Agent* get(int x, int y) const;
-
+    int cellCount() const { return width * height; }
     bool inBounds(int x, int y) const;
-    bool isEmpty(int x, int y) const;
 
     int mapX(int x) const;
     int mapY(int y) const;
     
     std::vector<std::pair<int, int>> getNeighborCoords(int x, int y) const;
 
-    void clear();
+    // Tablica sąsiedztwa: dla każdej komórki maxNeighbors() indeksów (y * width + x).
+    // Kolejność slotów jak w getNeighborCoords, sloty pochłonięte (Absorbing) na końcu mają -1.
+    // Przeliczana tylko gdy zmieni się boundary, neighborhood albo wymiary siatki.
+    void updateTopology();
+
+    int maxNeighbors() const { return topoStride; }
+    int neighborCount(int idx) const { return neighborCounts[idx]; }
+    const int32_t* neighborsOf(int idx) const { return neighborTable.data() + (size_t)idx * topoStride; }
+
+    // Krawędź zwrotna: dla slotu i komórki idx -> slot sąsiada, który wskazuje z powrotem na idx.
+    // Przy Fixed/Reflective ten sam sąsiad może wystąpić w kilku slotach (także sama komórka),
+    // wtedy k-te wystąpienie sąsiada u mnie paruje się z k-tym wystąpieniem mnie u sąsiada.
+    // -1 gdy brak pary (partner traktowany jak współpracujący).
+    const int8_t* reverseSlotsOf(int idx) const { return reverseTable.data() + (size_t)idx * topoStride; }
+
+    // Klasy kolorów grafu sąsiedztwa: komórki jednej klasy nie są sąsiadami (w żadną stronę),
+    // więc aktualizacje czytające tylko sąsiadów można w obrębie klasy robić równolegle.
+    // Kolorowanie zachłanne w kolejności rastrowej (Moore przy parzystych wymiarach: 4 klasy).
+    int colorCount() const { return (int)colorStart.size() - 1; }
+    int colorSize(int c) const { return colorStart[c + 1] - colorStart[c]; }
+    const int32_t* colorCells(int c) const { return colorOrder.data() + colorStart[c]; }
+
+private:
+    std::vector<int32_t> neighborTable;
+    std::vector<uint8_t> neighborCounts;
+    std::vector<int8_t> reverseTable;
+    std::vector<int32_t> colorOrder;  // komórki posortowane klasami, rosnąco w klasie
+    std::vector<int32_t> colorStart;  // początek klasy c w colorOrder (+ wartownik na końcu)
+    int topoStride = 0;
+
+    // Parametry, dla których zbudowano tablicę (do wykrywania zmian)
+    int topoWidth = -1;
+    int topoHeight = -1;
+    BoundaryMode topoBoundary = BoundaryMode::Periodic;
+    NeighborhoodType topoNeighborhood = NeighborhoodType::Moore;
 };
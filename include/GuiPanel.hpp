@@ -2,15 +2,26 @@
 #include <SFML/Graphics.hpp>
 #include <imgui.h>
 #include "Simulation.hpp"
+#include "SimulationController.hpp"
+#include <string>
 
 
 class GuiPanel {
 public:
-    GuiPanel(Simulation& sim, bool& running);
+    explicit GuiPanel(SimulationController& controller);
 
-    void update(sf::RenderWindow& window, LeftPanelMode& leftMode);
+    void update(sf::RenderWindow& window, LeftPanelMode& leftMode, const SimulationSnapshot& snap);
 
 private:
-    Simulation& sim;
-    bool& running;
+    SimulationController& controller;
+
+    // Parametry edytowane przez suwaki i ostatnio wysłane do silnika
+    SimulationParams params;
+    SimulationParams sentParams;
+
+    // Wysyła zmienione parametry (przed każdym innym poleceniem, żeby zachować kolejność)
+    void sendParams();
+
+    std::string checkpointStatus; // wynik ostatniego zapisu/odczytu punktu kontrolnego
+    std::string traceStatus;      // wynik ostatniego zapisu śladu
 };
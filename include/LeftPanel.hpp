@@ -9,26 +9,33 @@
 
 class LeftPanel {
 public:
-    LeftPanel(Simulation& sim, SimulationRenderer& renderer);
+    explicit LeftPanel(SimulationRenderer& renderer);
 
     void setSize(sf::Vector2u size);
     void setMode(LeftPanelMode m);
     LeftPanelMode getMode() const;
 
-    // rysuje lewy panel (ImGui okno bez ramek) i zawartość
-    void draw();
+    // rysuje lewy panel (ImGui okno bez ramek) i zawartość z opublikowanego stanu
+    void draw(const SimulationSnapshot& snap);
 
 private:
-    Simulation& sim;
     SimulationRenderer& renderer;
 
     LeftPanelMode mode = LeftPanelMode::Simulation;
 
-    sf::RenderTexture mapTexture;
+    sf::Vector2f viewSize{ (float)LEFT_PANEL_WIDTH, (float)WINDOW_HEIGHT };
+
+    // Widok planszy: kółko myszy przybliża wokół kursora, przeciąganie przesuwa,
+    // dwuklik wraca do całej planszy (dopasowanie śledzi też zmianę rozmiaru siatki)
+    GridView view;
+    bool fitView = true;
+    int viewGridWidth = 0;
+    int viewGridHeight = 0;
+    void handleViewInput(const SimulationSnapshot& snap, ImVec2 origin);
 
     // helpery do wykresów (bufory robocze)
-    void drawSimulationView();
-    void drawMetricsView();
+    void drawSimulationView(const SimulationSnapshot& snap);
+    void drawMetricsView(const SimulationSnapshot& snap);
 
     // dla „przesuwającego się wykresu”:
     int plotWindow = 600; // ile ostatnich próbek pokazujemy
@@ -0,0 +1,132 @@
+﻿#pragma once
+#include "PhaseTimers.hpp"
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct MetricsSample;
+
+// Binarny, kolumnowy log metryk (zamiast CSV przy bardzo długich przebiegach).
+//
+// Plik: nagłówek (schemat kolumn + parametry przebiegu jako "klucz=wartość"), potem bloki
+// dopisywane na końcu. Blok to do kilku tysięcy pokoleń, kolumna po kolumnie, z zakresem
+// pokoleń w nagłówku bloku, więc czytelnik może pominąć bloki spoza zakresu bez dekodowania,
+// a niedokończony ostatni blok (przebieg wciąż trwa) po prostu ignoruje.
+// Nowy przebieg w tym samym pliku (reset symulacji, ponowne uruchomienie z dopisywaniem)
+// zaczyna się kolejnym nagłówkiem; od niego do następnego nagłówka trwa segment.
+// Kompresja bloku (opcjonalna): kolumny całkowite jako różnice (zigzag + varint),
+// zmiennoprzecinkowe jako XOR z poprzednią wartością (varint). Bloki są niezależne.
+namespace MetricsLog {
+
+    static constexpr uint32_t VERSION = 1;
+
+    enum class ColumnType : uint8_t {
+        Int32,
+        Float32,
+        Float64
+    };
+
+    struct Column {
+        std::string name;
+        ColumnType type;
+    };
+
+    struct Header {
+        std::vector<Column> columns;      // kolumna 0 to zawsze Generation
+        std::vector<std::pair<std::string, std::string>> params; // parametry przebiegu (klucze SimulationConfig)
+        bool compressed = true;
+    };
+
+    // Liczba kolumn MetricsSample (bez czasów faz)
+    static constexpr size_t METRICS_COLUMNS = 23;
+
+    // Kolumny MetricsSample w kolejności CSV (writeMetricsCsvHeader), plus czasy faz w ms
+    std::vector<Column> metricsColumns(bool timingColumns);
+
+    // METRICS_COLUMNS wartości jako wzorce bitowe (jak z bitsOf), w kolejności metricsColumns
+    void metricsRow(const MetricsSample& m, uint64_t* out);
+
+    inline uint64_t bitsOf(int32_t v) { return (uint64_t)(uint32_t)v; }
+    uint64_t bitsOf(float v);
+    uint64_t bitsOf(double v);
+
+    // Zapis: wiersze zbierane w kolumnach bloku (bufory alokowane raz), blok kodowany do bajtów
+    class Encoder {
+    public:
+        static constexpr int DEFAULT_BLOCK_ROWS = 4096;
+
+        void begin(const Header& header, int blockRows = DEFAULT_BLOCK_ROWS);
+
+        // Nagłówek pliku (raz, na początku)
+        void writeHeader(std::string& out) const;
+
+        // values: jedna wartość na kolumnę, jak z bitsOf
+        void push(const uint64_t* values);
+
+        int pendingRows() const { return rows; }
+        bool blockFull() const { return rows >= blockRows; }
+
+        // Czas od pierwszego wiersza bloku (do domykania bloków przy wolnym przebiegu)
+        std::chrono::steady_clock::duration pendingAge() const;
+
+        // Dopisuje zakodowany blok (jeśli ma wiersze) i zaczyna nowy
+        void encodeBlock(std::string& out);
+
+    private:
+        Header schema;
+        int blockRows = DEFAULT_BLOCK_ROWS;
+        int rows = 0;
+        std::chrono::steady_clock::time_point firstRowTime{};
+        std::vector<std::vector<uint64_t>> columns;
+    };
+
+    // Odczyt strumieniowy: nagłówek, potem kolejne bloki (zakres pokoleń znany przed dekodowaniem)
+    class Reader {
+    public:
+        struct Block {
+            int rows = 0;
+            int firstGeneration = 0;
+            int lastGeneration = 0;
+            int segment = 0; // numer nagłówka, pod którym leży blok (0 = pierwszy)
+            uint64_t offset = 0; // położenie bloku w pliku
+            uint64_t bytes = 0;  // rozmiar bloku razem z jego nagłówkiem
+        };
+
+        bool open(const std::string& path, std::string& error);
+
+        // Nagłówek bieżącego segmentu (po nextBlock: segmentu zwróconego bloku)
+        const Header& header() const { return schema; }
+
+        // Następny kompletny blok, także za kolejnym nagłówkiem. false na końcu pliku albo przy
+        // niedokończonym bloku trwającego przebiegu (error puste), a przy bajtach, których nie da
+        // się odczytać, false z opisem w error.
+        bool nextBlock(Block& block, std::string& error);
+
+        // Dekoduje bieżący blok do kolumn (wartości jak z bitsOf), albo go pomija
+        bool readBlock(std::vector<std::vector<uint64_t>>& columns, std::string& error);
+        void skipBlock();
+
+        // Wartość kolumny jako tekst (liczby jak w eksporcie CSV)
+        static char* formatValue(char* out, ColumnType type, uint64_t bits);
+
+    private:
+        // Nagłówek od bieżącej pozycji; incomplete = plik urywa się w środku (dopisywany)
+        bool readHeader(std::string& error, bool& incomplete);
+
+        std::ifstream in;
+        std::string filePath;
+        Header schema;
+        int segmentIndex = 0;
+        uint32_t payloadBytes = 0;
+        uint8_t encoding = 0;
+        int blockRowCount = 0;
+        bool payloadPending = false;
+    };
+
+    // Obcina log tuż za ostatnim wierszem z pokoleniem <= generation (wznowienie z punktu
+    // kontrolnego: późniejsze pokolenia policzymy jeszcze raz). Blok na granicy jest przepisywany.
+    bool truncateAfter(const std::string& path, int generation, std::string& error);
+}
@@ -0,0 +1,70 @@
+﻿#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Dopisywanie wierszy metryk do pliku bez czekania na dysk w wątku symulacji.
+// Plik jest otwarty przez cały zapis; wiersze trafiają do bufora w pamięci, który po
+// przekroczeniu progu rozmiaru albo czasu jest oddawany wątkowi I/O (podwójne buforowanie).
+// Jeśli wątek I/O nie nadąża, bufor bieżący po prostu rośnie - append() nigdy nie czeka.
+class MetricsWriter {
+public:
+    static constexpr size_t DEFAULT_FLUSH_BYTES = size_t(1) << 20;
+    static constexpr std::chrono::milliseconds DEFAULT_FLUSH_INTERVAL{ 1000 };
+
+    MetricsWriter() = default;
+    ~MetricsWriter();
+
+    MetricsWriter(const MetricsWriter&) = delete;
+    MetricsWriter& operator=(const MetricsWriter&) = delete;
+
+    // Otwiera plik (dopisywanie albo od zera) i uruchamia wątek I/O; zamyka poprzedni
+    bool open(const std::string& path, bool truncate);
+
+    // Zapisuje resztę bufora, zatrzymuje wątek I/O i zamyka plik
+    void close();
+
+    bool isOpen() const { return file != nullptr; }
+    const std::string& path() const { return filePath; }
+
+    // Progi oddania bufora do zapisu (rozmiar w bajtach, czas od ostatniego oddania)
+    void setThresholds(size_t bytes, std::chrono::milliseconds interval);
+
+    // Wątek symulacji: kopiuje dane do bufora, najwyżej budzi wątek I/O
+    void append(const char* data, size_t size);
+    void append(const std::string& s) { append(s.data(), s.size()); }
+
+    // Oddaje bufor i czeka, aż wszystko trafi do pliku (np. przed punktem kontrolnym).
+    // false, jeśli którykolwiek zapis się nie powiódł.
+    bool flush();
+
+    bool failed() const { return writeFailed.load(std::memory_order_relaxed); }
+
+private:
+    // Podmienia bufor bieżący z wolnym i budzi wątek I/O; false, gdy poprzedni jeszcze się pisze
+    bool handOff();
+    void ioLoop();
+
+    std::FILE* file = nullptr;
+    std::string filePath;
+
+    size_t flushBytes = DEFAULT_FLUSH_BYTES;
+    std::chrono::milliseconds flushInterval = DEFAULT_FLUSH_INTERVAL;
+    std::chrono::steady_clock::time_point lastHandOff{};
+
+    std::string front;         // dopisywany przez wątek symulacji
+    std::string back;          // zapisywany przez wątek I/O, gdy backPending
+    bool backPending = false;
+    bool stopping = false;
+    std::atomic<bool> writeFailed{ false };
+
+    std::mutex mutex;
+    std::condition_variable wake;      // budzi wątek I/O
+    std::condition_variable written;   // sygnał "back zapisany" dla flush()
+    std::thread ioThread;
+};
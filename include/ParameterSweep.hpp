@@ -0,0 +1,50 @@
+﻿#pragma once
+#include "Simulation.hpp"
+#include "SimulationConfig.hpp"
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// Sweep parametrów (diagramy fazowe): siatka wartości × replikacje, każde zadanie to osobna
+// Simulation liczona na jednym rdzeniu, a wiele zadań idzie naraz na puli wątków.
+
+struct SweepAxis {
+    std::string key;                 // klucz jak w SimulationConfig (np. "T", "fermi_k")
+    std::vector<std::string> values;
+};
+
+struct SweepJob {
+    int point = 0;                       // indeks punktu siatki parametrów
+    int replicate = 0;
+    uint64_t seed = 0;
+    SimulationConfig::Entries settings;  // wartości osi w tym punkcie
+};
+
+struct SweepResult {
+    SweepJob job;
+    MetricsSample final{};   // metryki ostatniego pokolenia
+    double seconds = 0.0;
+    bool ok = false;
+    std::string error;
+};
+
+namespace ParameterSweep {
+
+    // Oś z opisu "start:stop:krok" (zakres włącznie) albo listy "a,b,c"
+    bool parseAxis(const std::string& key, const std::string& spec, SweepAxis& out, std::string& error);
+
+    // Iloczyn kartezjański osi × replikacje. Replikacja r ma ten sam seed we wszystkich punktach
+    // (wspólne liczby losowe), więc różnice między punktami nie mieszają się z szumem startu.
+    std::vector<SweepJob> expand(const std::vector<SweepAxis>& axes, int replicates, uint64_t baseSeed);
+
+    // Liczy zadania na `threads` wątkach; OpenMP wewnątrz zadania jest ograniczone do 1 wątku,
+    // żeby instancje nie walczyły o rdzenie. `base` stosowane przed ustawieniami zadania.
+    // onDone (opcjonalne) wołane po każdym zadaniu, szeregowo.
+    std::vector<SweepResult> run(const SimulationConfig::Entries& base, const std::vector<SweepJob>& jobs,
+        int generations, int threads, const std::function<void(const SweepResult&, size_t done)>& onDone = {});
+
+    // Tabela wyników: kolumny osi, replikacja, seed, czas, metryki końcowe
+    void writeCsv(std::ostream& out, const std::vector<SweepAxis>& axes, const std::vector<SweepResult>& results);
+}
@@ -0,0 +1,102 @@
+﻿#pragma once
+#include "Trace.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+// Fazy pokolenia mierzone przez PhaseTimers. RoundDecide/RoundPayoff/RoundApply to trzy
+// sekcje OpenMP playOneRound (sumowane po K rundach), zawierają się w Rounds.
+enum class Phase {
+    Movement,
+    Rounds,
+    RoundDecide,
+    RoundPayoff,
+    RoundApply,
+    Evolution,   // death-birth albo imitacja
+    Metrics,
+    Export,
+    Count
+};
+
+static constexpr size_t PHASE_COUNT = (size_t)Phase::Count;
+
+// Nazwy faz (GUI, nagłówki CSV)
+inline const char* phaseName(Phase p) {
+    static constexpr const char* names[PHASE_COUNT] = {
+        "Movement", "Rounds", "RoundDecide", "RoundPayoff", "RoundApply", "Evolution", "Metrics", "Export"
+    };
+    return names[(size_t)p];
+}
+
+// Czasy faz jednego pokolenia w milisekundach, plus czas całego step()
+struct PhaseTimes {
+    std::array<double, PHASE_COUNT> ms{};
+    double totalMs = 0.0;
+
+    double operator[](Phase p) const { return ms[(size_t)p]; }
+};
+
+// Lekkie liczniki czasu faz: mark() na początku fazy, add(faza, mark) na końcu.
+// Mierzone z wątku głównego wokół regionów równoległych, więc to czas ścienny fazy.
+// Bez SOCIALEVO_ENABLE_TIMING wszystko jest pustymi funkcjami inline i znika z kodu.
+class PhaseTimers {
+public:
+#ifdef SOCIALEVO_ENABLE_TIMING
+    static constexpr bool enabled = true;
+    using Mark = std::chrono::steady_clock::time_point;
+
+    Mark mark() const { return std::chrono::steady_clock::now(); }
+
+    void add(Phase p, Mark since) {
+        current.ms[(size_t)p] += std::chrono::duration<double, std::milli>(mark() - since).count();
+    }
+
+    void beginGeneration() {
+        current = PhaseTimes{};
+        generationStart = mark();
+    }
+
+    void endGeneration() {
+        current.totalMs = std::chrono::duration<double, std::milli>(mark() - generationStart).count();
+        completed = current;
+    }
+#else
+    static constexpr bool enabled = false;
+    struct Mark {};
+
+    Mark mark() const { return {}; }
+    void add(Phase, Mark) {}
+    void beginGeneration() {}
+    void endGeneration() {}
+#endif
+
+    // Pokolenie w toku (np. dla eksportu CSV, zanim skończy się step)
+    const PhaseTimes& inProgress() const { return current; }
+
+    // Ostatnie zakończone pokolenie
+    const PhaseTimes& last() const { return completed; }
+
+private:
+    PhaseTimes current;
+    PhaseTimes completed;
+#ifdef SOCIALEVO_ENABLE_TIMING
+    Mark generationStart{};
+#endif
+};
+
+// Faza mierzona naraz przez PhaseTimers i ślad wykonania (Trace); end() zamyka oba pomiary
+class PhaseSpan {
+public:
+    PhaseSpan(PhaseTimers& t, Phase p) : timers(t), phase(p), start(t.mark()), trace(phaseName(p)) {}
+
+    void end() {
+        timers.add(phase, start);
+        trace.end();
+    }
+
+private:
+    PhaseTimers& timers;
+    Phase phase;
+    PhaseTimers::Mark start;
+    Trace::Scope trace;
+};
@@ -0,0 +1,47 @@
+﻿#pragma once
+#include <cstddef>
+#include <vector>
+
+// Bufor cykliczny o stałej pojemności (historia metryk bez alokacji w trakcie symulacji).
+// Po zapełnieniu push_back nadpisuje najstarszy element; indeks 0 to zawsze najstarszy.
+template <typename T>
+class RingBuffer {
+public:
+    explicit RingBuffer(size_t capacity = 0) { setCapacity(capacity); }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return data.size(); }
+    bool empty() const { return count == 0; }
+
+    const T& operator[](size_t i) const { return data[(head + i) % data.size()]; }
+    const T& back() const { return (*this)[count - 1]; }
+
+    void push_back(const T& v) {
+        if (data.empty()) return;
+        data[(head + count) % data.size()] = v;
+        if (count < data.size()) count++;
+        else head = (head + 1) % data.size();
+    }
+
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+
+    // Zmienia pojemność (alokuje), zachowując najnowsze elementy
+    void setCapacity(size_t capacity) {
+        std::vector<T> fresh(capacity);
+        size_t keep = (count < capacity) ? count : capacity;
+        for (size_t i = 0; i < keep; ++i) {
+            fresh[i] = (*this)[count - keep + i];
+        }
+        data.swap(fresh);
+        head = 0;
+        count = keep;
+    }
+
+private:
+    std::vector<T> data;
+    size_t head = 0;
+    size_t count = 0;
+};
@@ -0,0 +1,35 @@
+﻿#pragma once
+#include <cstdint>
+
+// Wektorowe jądro jednej rundy IPD na spakowanych bitowo planszach akcji.
+// Każda komórka ma jeden bajt na 8 slotów sąsiadów: bit i = 1 oznacza Defect w slocie i.
+// Ścieżki: AVX2 (32 komórki na instrukcję), SSE2 (16 komórek), skalarna (reszta i inne CPU).
+namespace RoundKernel {
+
+    // Pavlov (Win-Stay, Lose-Shift): czy zostać przy swojej akcji po danym wyniku.
+    // 0xFF = zostań, 0x00 = zmień. Wyliczane raz na rundę z macierzy i progu.
+    struct PavlovRule {
+        uint8_t stayCC, stayCD, stayDC, stayDD;
+    };
+
+    // Decyzje wobec wszystkich sąsiadów dla n komórek.
+    // type         - AgentType komórki (bajt)
+    // activeSlots  - maska slotów w użyciu (0 dla pustej komórki)
+    // myLast/theirLast - pamięć ostatniej rundy per slot
+    // discBits     - gotowe decyzje Dyskryminatora (zależą od reputacji sąsiadów)
+    void decide(const uint8_t* type, const uint8_t* activeSlots,
+        const uint8_t* myLast, const uint8_t* theirLast, const uint8_t* discBits,
+        uint8_t* out, int n, PavlovRule rule);
+
+    // Zlicza wyniki par (ja, partner) po slotach z żywym partnerem (occupied).
+    // Wynik: liczba CC, CD, DC, DD na komórkę.
+    void countOutcomes(const uint8_t* my, const uint8_t* his, const uint8_t* occupied,
+        uint8_t* nCC, uint8_t* nCD, uint8_t* nDC, uint8_t* nDD, int n);
+
+    // Liczba ustawionych bitów w bajcie (liczba zdrad w slotach)
+    inline int popcount8(uint8_t v) {
+        v = v - ((v >> 1) & 0x55);
+        v = (v & 0x33) + ((v >> 2) & 0x33);
+        return (v + (v >> 4)) & 0x0F;
+    }
+}
@@ -1,11 +1,16 @@
 ﻿#pragma once
 #include "Grid.hpp"
+#include "AgentStore.hpp"
+#include "RingBuffer.hpp"
+#include "CounterRng.hpp"
+#include "PhaseTimers.hpp"
+#include "MetricsLog.hpp"
+#include "MetricsWriter.hpp"
 #include "constants.hpp"
-#include <random>
-#include <deque>
+#include <cstdint>
+#include <iosfwd>
 #include <string>
 #include <vector>
-#include <memory>
 
 enum class UpdateRule {
     BestNeighbor,
@@ -17,6 +22,18 @@ enum class EvolutionMode {
     DeathBirth
 };
 
+// Kolejność aktualizacji faz zależnych od sąsiadów (narodziny, migracja)
+enum class UpdateScheduling {
+    Serial,   // komórka po komórce (klasyczna semantyka, jeden wątek)
+    Parallel  // równolegle z deterministycznym rozstrzyganiem konfliktów
+};
+
+// Format pliku metryk pokoleń
+enum class MetricsFormat {
+    Csv,    // tekst, jeden wiersz na pokolenie
+    Binary  // kolumnowy log binarny (MetricsLog.hpp), czytany przez social-evolution-log
+};
+
 enum class LeftPanelMode {
     Simulation,
     Metrics
@@ -57,22 +74,128 @@ struct MetricsSample {
     float avgStrategyAge = 0.0f; // Średni wiek (stabilność)
 };
 
+// Kolumny CSV metryk (bez końca linii), wspólne dla eksportu pokoleń i tabel wyników
+void writeMetricsCsvHeader(std::ostream& out);
+void writeMetricsCsvRow(std::ostream& out, const MetricsSample& m);
+
+// Ten sam wiersz formatowany std::to_chars (bez locale i strumieni) do bufora o rozmiarze
+// co najmniej METRICS_CSV_ROW_MAX; zwraca wskaźnik za ostatnim znakiem
+static constexpr size_t METRICS_CSV_ROW_MAX = 512;
+char* formatMetricsCsvRow(char* out, const MetricsSample& m);
+
+// Liczniki populacji utrzymywane przyrostowo w miejscach, gdzie się zmieniają (narodziny, śmierć,
+// zmiana typu w imitacji, akcje w rundzie), więc metryki i cooperationRate() nie skanują siatki
+struct PopulationCounts {
+    int alive = 0;
+    int coop = 0; // żywi z currentAction == Cooperate
+    int perType[AGENT_TYPE_COUNT] = {};
+
+    void add(AgentType t, Action a) {
+        alive++;
+        perType[(int)t]++;
+        if (a == Action::Cooperate) coop++;
+    }
+
+    void remove(AgentType t, Action a) {
+        alive--;
+        perType[(int)t]--;
+        if (a == Action::Cooperate) coop--;
+    }
+
+    // Scalanie zmian policzonych lokalnie przez wątki (liczby całkowite, więc kolejność jest obojętna)
+    PopulationCounts& operator+=(const PopulationCounts& d) {
+        alive += d.alive;
+        coop += d.coop;
+        for (int t = 0; t < AGENT_TYPE_COUNT; ++t) perType[t] += d.perType[t];
+        return *this;
+    }
+
+    bool operator==(const PopulationCounts&) const = default;
+};
+
 class Simulation {
 private:
-    std::vector<std::unique_ptr<Agent>> agents;
-    std::mt19937 rng;
-
     bool csvHeaderWritten = false;
-    std::vector<Agent*> deadPool;
+    bool csvTimingColumns = false; // układ kolumn bieżącego pliku CSV
+    MetricsWriter metricsSink;     // plik metryk otwarty przez cały zapis, zapis w tle
+
+    // Log binarny: blok w budowie i bufor na zakodowane bajty
+    MetricsLog::Encoder logEncoder;
+    bool logStarted = false;
+    std::string logBytes;
+
+    // Dopisuje niepełny blok logu binarnego do pliku (przed flush/zamknięciem)
+    void emitLogBlock();
+    void closeMetricsFile();
+
+    PopulationCounts population;
+
+    // Sumy cech jednego bloku KERNEL_BLOCK komórek, liczone w ostatnim równoległym przejściu
+    // ewolucji. Bloki są składane w stałej kolejności, więc średnie nie zależą od liczby wątków.
+    struct TraitSums {
+        double payoff[AGENT_TYPE_COUNT] = {};
+        double reputation[AGENT_TYPE_COUNT] = {};
+        double reputationAll = 0.0;
+        double strategyAge = 0.0;
 
-    float expectedPayoffAt(int x, int y, Action s) const;
+        void add(const AgentStore& a, int idx) {
+            const int t = (int)a.type[idx];
+            payoff[t] += a.payoff[idx];
+            reputation[t] += a.reputation[idx];
+            reputationAll += a.reputation[idx];
+            strategyAge += a.strategyAge[idx];
+        }
+    };
+
+    // true, gdy scratch.blockTraits odpowiada bieżącemu stanowi agentów
+    bool traitsCurrent = false;
+
+    // Pełne przejście po siatce: liczniki (reset, wczytany stan, kontrola w buildach debug)
+    // i sumy cech (gdy nie policzyło ich pokolenie)
+    PopulationCounts countPopulation() const;
+    void sumTraits();
+
+    // Bufory robocze pokolenia: alokowane raz na rozmiar siatki, potem tylko nadpisywane,
+    // żeby step() w stanie ustalonym nie dotykał alokatora.
+    struct Scratch {
+        std::vector<uint8_t> activeSlots;   // sloty w użyciu
+        std::vector<uint8_t> occupiedSlots; // sloty z żywym sąsiadem
+        std::vector<uint8_t> discBits;      // decyzje Dyskryminatora
+        std::vector<uint8_t> decisions;     // moje akcje wobec slotów
+        std::vector<uint8_t> hisBits;       // akcje partnerów wobec mnie
+        std::vector<uint8_t> nCC, nCD, nDC, nDD;
+        std::vector<float> roundPayoff;
+        std::vector<int> order;             // kolejność ruchu
+        std::vector<AgentType> nextTypes;   // synchroniczna imitacja
+        std::vector<int> imitPartner;       // wybrany sąsiad (-1 = decyzja już zapadła)
+        std::vector<float> imitArg;         // argument exp, potem prawdopodobieństwo Fermiego
+        std::vector<float> imitDraw;        // losowanie do porównania z prawdopodobieństwem
+        std::vector<uint8_t> born;          // narodziny w tym pokoleniu (do nadania ID)
+        std::vector<int> moveTarget;        // propozycja ruchu (-1 = zostaje)
+        std::vector<uint64_t> moveClaim;    // najwyższy klucz zgłoszony do pustego pola
+        std::vector<TraitSums> blockTraits; // sumy cech per blok komórek
+    } scratch;
+
+    void prepareScratch();
+
+    // Szablony na stencilu sąsiedztwa (Stencil.hpp): nb daje countAt/neighbor/reverse,
+    // view rozstrzyga wnętrze/brzeg dla dowolnej komórki. Definicje w Simulation.cpp.
+    template <class Nb>
+    float expectedPayoffAt(int idx, const Nb& nb, Action s) const;
     float payoffVs(Action a, Action b) const;
 
-    // Jedna SYNCHRONICZNA runda gry (bez ruchu)
-    void playOneRound();
+    // Najlepsze pole dla ruchu agenta z idx (idx = zostaje); czyta tylko stan, nic nie zmienia
+    template <class View, class Nb>
+    int chooseMoveTarget(const View& view, int idx, const Nb& nb) const;
+
+    // Losowanie narodzin w pustej komórce: true + typ dziecka, jeśli ktoś się rodzi.
+    // Czyta tylko sąsiadów komórki, więc komórki jednej klasy kolorów są niezależne.
+    template <class Nb>
+    bool chooseNewborn(int idx, const Nb& nb, AgentType& childType) const;
 
 public:
     Grid grid;
+    AgentStore agents; // stan agentów, indeksowany komórką siatki
     PayoffMatrix matrix;
 
     EvolutionMode mode = EvolutionMode::DeathBirth;
@@ -91,6 +214,7 @@ public:
     float density = 0.7f;
     float moveProb = 0.1f;         // szansa ruchu raz na pokolenie 0.3f
     float moveEpsilon = 0.05f;     // minimalna poprawa żeby ruszać (success-driven)
+    UpdateScheduling migrationScheduling = UpdateScheduling::Serial;
 
     // IPD: K rund na pokolenie (payoff uśredniany)
     int roundsPerGeneration = 20;
@@ -103,6 +227,7 @@ public:
     float reproductionProb = 0.3f;
     float deathProb = 0.02f;
     float selectionBeta = 1.0f;
+    UpdateScheduling birthScheduling = UpdateScheduling::Serial;
 
     bool normalizePayoff = true; // avg po sąsiadach w każdej rundzie
 
@@ -112,23 +237,62 @@ public:
 
     int generation = 0;
 
+    // Ziarno generatora licznikowego: (seed, generation, komórka, faza) wyznacza wszystkie losowania,
+    // więc ten sam seed daje ten sam przebieg niezależnie od liczby wątków
+    uint64_t seed = 0;
+
     MetricsSample lastMetrics{};
-    std::deque<MetricsSample> history;
+    RingBuffer<MetricsSample> history{ 2000 };
     size_t historyMax = 2000;
 
     bool exportCsvEnabled = false;
     std::string exportPath = "metrics.csv";
+    bool exportTimings = false; // dodatkowe kolumny Time_* (w ms) w CSV
+    MetricsFormat exportFormat = MetricsFormat::Csv;
+    bool exportCompression = true; // kompresja bloków logu binarnego
+
+    // Czasy faz pokolenia (puste bez SOCIALEVO_ENABLE_TIMING)
+    PhaseTimers timers;
 
     Simulation(int width, int height, PayoffMatrix m);
+    ~Simulation();
 
     void step();
+
+    // Jedna SYNCHRONICZNA runda gry (bez ruchu); step() woła ją K razy.
+    // Publiczna dla benchmarków: zakłada aktualną topologię i bufory (po reset() albo step()).
+    void playOneRound();
+
+    // Strumień losowy komórki w bieżącym pokoleniu
+    CellRng cellRng(int idx, RngPhase phase) const;
+
+    // Losuje nowe ziarno (np. dla RESET z nową populacją)
+    void randomizeSeed();
+    static uint64_t randomSeed();
+
+    // O(1): z liczników populacji
     float cooperationRate() const;
 
+    const PopulationCounts& populationCounts() const { return population; }
+
+    // Przelicza liczniki populacji od zera; po zmianie agentów z zewnątrz (np. wczytanie stanu)
+    void recountPopulation();
+
     void recordMetrics();
     void exportMetricsRowIfNeeded();
 
     // Funkcja do czyszczenia pliku CSV
     void newCsvFile();
 
+    // Dopisywanie do istniejącego pliku (po wczytaniu punktu kontrolnego): plik jest obcinany
+    // za wierszem bieżącego pokolenia. CSV musi mieć ten sam nagłówek (kolumny czasów), log
+    // binarny dostaje nowy nagłówek z bieżącymi parametrami. false z opisem w error, gdy
+    // plik nie pasuje do formatu eksportu.
+    bool continueCsvFile(std::string& error);
+
+    // Czeka, aż wszystkie wiersze CSV trafią do pliku (przed punktem kontrolnym, na końcu
+    // przebiegu); false przy błędzie zapisu
+    bool flushCsvFile();
+
     void reset();
 };
@@ -4,6 +4,7 @@
 #include <imgui-SFML.h>
 
 #include "Simulation.hpp"
+#include "SimulationController.hpp"
 #include "SimulationRenderer.hpp"
 #include "LeftPanel.hpp"
 #include "GuiPanel.hpp"
@@ -19,11 +20,12 @@ private:
     sf::RenderWindow window;
     sf::Clock deltaClock;
 
+    // Symulację zmienia tylko kontroler (wątek silnika); GUI czyta opublikowany stan.
+    // Kontroler jest niszczony przed sim, więc wątek silnika kończy się pierwszy.
     Simulation sim;
+    SimulationController controller;
     SimulationRenderer renderer;
     LeftPanel leftPanel;
     LeftPanelMode leftMode = LeftPanelMode::Simulation;
     GuiPanel gui;
-
-    bool running = false;
 };
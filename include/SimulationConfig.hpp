@@ -0,0 +1,26 @@
+﻿#pragma once
+#include "Simulation.hpp"
+#include <string>
+#include <utility>
+#include <vector>
+
+// Ustawianie parametrów symulacji z tekstu: plik konfiguracyjny (klucz = wartość)
+// albo argumenty wiersza poleceń (--klucz wartość). Wspólne dla narzędzi bez GUI.
+namespace SimulationConfig {
+
+    using Entries = std::vector<std::pair<std::string, std::string>>;
+
+    // Ustawia jeden parametr. false + opis w `error` dla nieznanego klucza albo złej wartości.
+    // Zmiany wymiarów, brzegów i strategii zaczynają działać po sim.reset().
+    bool apply(Simulation& sim, const std::string& key, const std::string& value, std::string& error);
+
+    // Czyta plik "klucz = wartość" (komentarze od '#', puste linie pomijane) do listy wpisów
+    bool loadFile(const std::string& path, Entries& out, std::string& error);
+
+    // Bieżące wartości wszystkich parametrów pod tymi samymi kluczami (apply() każdej pary
+    // odtwarza ustawienia; np. do zapisania przebiegu w nagłówku logu)
+    Entries currentValues(const Simulation& sim);
+
+    // Lista obsługiwanych kluczy (do --help)
+    std::string describeKeys();
+}
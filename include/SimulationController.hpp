@@ -0,0 +1,196 @@
+﻿#pragma once
+#include "Simulation.hpp"
+#include "SpscQueue.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Parametry edytowane w GUI. Interfejs trzyma własną kopię (suwaki piszą do niej), a zmiany
+// wysyła do silnika poleceniem, więc nigdy nie dotyka pól symulacji liczonej w innym wątku.
+struct SimulationParams {
+    bool useAlwaysCooperate = true;
+    bool useAlwaysDefect = true;
+    bool useTitForTat = true;
+    bool usePavlov = true;
+    bool useDiscriminator = true;
+    float density = 0.0f;
+    uint64_t seed = 0;
+
+    PayoffMatrix matrix{};
+    bool normalizePayoff = true;
+
+    BoundaryMode boundary = BoundaryMode::Periodic;
+    NeighborhoodType neighborhood = NeighborhoodType::Moore;
+
+    EvolutionMode mode = EvolutionMode::DeathBirth;
+    UpdateRule updateRule = UpdateRule::Fermi;
+    float fermiK = 0.0f;
+    float mutationRate = 0.0f;
+    float reproductionProb = 0.0f;
+    float deathProb = 0.0f;
+    float selectionBeta = 0.0f;
+    UpdateScheduling birthScheduling = UpdateScheduling::Serial;
+
+    float moveProb = 0.0f;
+    float moveEpsilon = 0.0f;
+    UpdateScheduling migrationScheduling = UpdateScheduling::Serial;
+
+    int roundsPerGeneration = 1;
+    float reputationAlpha = 0.0f;
+    float reputationThreshold = 0.0f;
+
+    bool exportCsvEnabled = false;
+    bool exportTimings = false;
+
+    static SimulationParams capture(const Simulation& sim);
+    void applyTo(Simulation& sim) const;
+
+    bool operator==(const SimulationParams&) const = default;
+};
+
+// Stan opublikowany dla interfejsu: plansza do rysowania, metryki, historia wykresów i czasy.
+// Kopiowany z symulacji między pokoleniami; bufory są alokowane raz na rozmiar siatki.
+struct SimulationSnapshot {
+    int generation = 0;
+    int width = 0;
+    int height = 0;
+
+    // Numer publikacji (kolejne stany mają kolejne numery). Różnica większa niż 1 względem
+    // ostatnio narysowanego stanu oznacza pominięty stan, więc `changed` nie wystarczy.
+    uint64_t sequence = 0;
+
+    // Tablice planszy; bez rysowania (hasGrid == false) nie są kopiowane i mogą być nieaktualne
+    bool hasGrid = false;
+    std::vector<uint8_t> alive;
+    std::vector<AgentType> type;
+    std::vector<Action> visualAction;
+    std::vector<uint64_t> changed; // komórki zmienione od poprzedniej publikacji (AgentStore::changed)
+
+    MetricsSample lastMetrics{};
+    RingBuffer<MetricsSample> history;
+    float cooperationRate = 0.0f;
+    PhaseTimes times{};
+    double generationsPerSecond = 0.0;
+    int generationsPerFrame = 0; // pokolenia policzone w ostatniej klatce (tryb inline)
+
+    void capture(const Simulation& sim, bool withGrid = true);
+};
+
+// Silnik symulacji dla GUI. W trybie wątkowym pokolenia liczy osobny wątek z pełną prędkością,
+// a interfejs czyta ostatni opublikowany stan (podwójne buforowanie) i wysyła polecenia przez
+// kolejkę bez blokad; polecenia są wykonywane między pokoleniami. W trybie inline wszystko
+// dzieje się w frame(), w wątku GUI: jedno pokolenie na klatkę albo (z budżetem klatki) tyle,
+// ile zmieści się w zadanym czasie.
+//
+// Po utworzeniu kontrolera symulację zmienia się tylko przez post() albo exclusive().
+class SimulationController {
+public:
+    using Command = std::function<void(Simulation&)>;
+
+    // Pojemność kolejki poleceń (wątek GUI wysyła najwyżej kilka poleceń na klatkę)
+    static constexpr size_t COMMAND_CAPACITY = 256;
+
+    explicit SimulationController(Simulation& sim, bool threaded = true);
+    ~SimulationController();
+
+    SimulationController(const SimulationController&) = delete;
+    SimulationController& operator=(const SimulationController&) = delete;
+
+    void setThreaded(bool on);
+    bool threaded() const { return worker.joinable(); }
+
+    void setRunning(bool on);
+    bool running() const { return runFlag.load(std::memory_order_relaxed); }
+
+    // Tryb inline: czas na pokolenia w jednej klatce [ms]. 0 = jedno pokolenie na klatkę.
+    // Kolejne pokolenie startuje, jeśli według średniego czasu pokolenia zmieści się w budżecie.
+    void setFrameBudget(double ms) { frameBudgetMs = ms; }
+    double frameBudget() const { return frameBudgetMs; }
+
+    // Bez rysowania planszy stan nie zawiera tablic siatki (tylko metryki), więc publikacja
+    // jest tańsza; po ponownym włączeniu plansza jest publikowana od razu
+    void setCaptureGrid(bool on);
+    bool captureGrid() const { return gridFlag.load(std::memory_order_relaxed); }
+
+    // Wątek GUI: polecenie wykonywane między pokoleniami, w kolejności wysłania.
+    // Przy pełnej kolejce czeka na wolne miejsce (polecenia nie giną).
+    void post(Command cmd);
+
+    // Wątek GUI: bezpośredni dostęp do symulacji, np. zapis/odczyt stanu albo ślad.
+    // Czeka na koniec bieżącego pokolenia i wykonuje f w wątku wołającym; po powrocie
+    // stan jest publikowany na nowo.
+    template <class F>
+    void exclusive(F&& f) {
+        lockEngine();
+        f(sim);
+        unlockEngine();
+    }
+
+    // Wątek GUI, raz na klatkę. W trybie inline wykonuje polecenia, pokolenie (gdy działa)
+    // i publikuje stan; w trybie wątkowym nic nie robi.
+    void frame();
+
+    // Wątek GUI: ostatni opublikowany stan, ważny do release(). Silnik w tym czasie
+    // pisze do drugiego bufora, więc odczyt nigdy go nie zatrzymuje.
+    const SimulationSnapshot& acquire();
+    void release();
+
+private:
+    void workerLoop();
+    void startWorker();
+    void stopWorker();
+
+    // Jeden krok silnika pod engineMutex: polecenia, pokolenia (gdy działa; więcej niż jedno
+    // tylko przy dodatnim budżecie) i publikacja stanu
+    void advance(double budgetMs);
+
+    // Wykonuje polecenia z kolejki; true, jeśli było choć jedno
+    bool drainCommands();
+
+    // Kopiuje stan do wolnego bufora; false, gdy interfejs nie odebrał jeszcze poprzedniego
+    // albo czyta bufor, który byłby nadpisany
+    bool publish();
+    void captureInto(SimulationSnapshot& snap);
+    void countGeneration();
+
+    void lockEngine();
+    void unlockEngine();
+    void wake();
+
+    Simulation& sim;
+
+    SpscQueue<Command, COMMAND_CAPACITY> commands;
+
+    std::thread worker;
+    std::atomic<bool> quit{ false };
+    std::atomic<bool> runFlag{ false };
+    std::atomic<bool> gridFlag{ true };
+    std::atomic<uint32_t> wakeups{ 0 };      // budzenie uśpionego wątku (polecenie, start, odbiór stanu)
+    std::atomic<bool> exclusiveWaiting{ false };
+
+    // Trzymany przez silnik na czas pokolenia/poleceń, przez GUI w exclusive()
+    std::mutex engineMutex;
+    bool dirty = true; // stan zmienił się od ostatniej publikacji (pod engineMutex)
+
+    // Podwójny bufor stanu: front czyta GUI, drugi wypełnia silnik
+    std::mutex snapshotMutex;
+    SimulationSnapshot buffers[2];
+    int front = 0;
+    int reading = -1;      // bufor trzymany przez GUI między acquire() a release()
+    bool consumed = true;  // GUI odebrało front od ostatniej publikacji
+    uint64_t published = 0; // licznik publikacji (SimulationSnapshot::sequence)
+
+    // Tempo pokoleń (do wyświetlenia)
+    std::chrono::steady_clock::time_point rateStart{};
+    int rateCount = 0;
+    double generationsPerSecond = 0.0;
+    int generationsPerFrame = 0;
+
+    // Budżet klatki trybu inline i średni czas pokolenia (średnia wykładnicza) [ms]
+    double frameBudgetMs = 0.0;
+    double stepEstimateMs = 0.0;
+};
@@ -1,14 +1,132 @@
 ﻿#pragma once
 #include <SFML/Graphics.hpp>
-#include "Simulation.hpp"
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "SimulationController.hpp"
 
+// Kolor komórki: tożsamość (typ) + cieniowanie dominującą akcją (visualAction)
+sf::Color agentColor(AgentType type, Action visualAction);
+
+// Wycinek planszy widoczny w panelu: komórka w lewym górnym rogu (ułamkowo) i skala
+struct GridView {
+    float originX = 0.0f;
+    float originY = 0.0f;
+    float scale = 1.0f; // piksele ekranu na komórkę
+
+    // Cała plansza w panelu (tak jak dawniej: szerokość planszy = szerokość panelu)
+    static GridView fit(int width, int height, sf::Vector2f panel);
+
+    bool operator==(const GridView&) const = default;
+};
+
+// Jak kolorować kafelki po oddaleniu (blok komórek na piksel)
+enum class TileShading : uint8_t {
+    MajorityType, // kolor najliczniejszego typu, ciemniejszy przy zdradzie
+    Cooperation   // odsetek współpracujących: od czerwonego do zielonego
+};
+
+// Liczniki bloku komórek (kafelka piramidy)
+struct TileCounts {
+    uint32_t perType[AGENT_TYPE_COUNT] = {};
+    uint32_t coop = 0; // żywi z visualAction == Cooperate
+
+    uint32_t alive() const;
+    TileCounts& operator+=(const TileCounts& o);
+};
+
+// Rysuje planszę z opublikowanego stanu (SimulationSnapshot), nie z żywej symulacji.
+//
+// Obraz obejmuje tylko widoczny wycinek, jeden piksel tekstury na jednostkę: komórkę przy
+// przybliżeniu albo kafelek 2^L x 2^L komórek przy oddaleniu (poziom L dobrany tak, żeby
+// kafelek zajmował 1-2 piksele ekranu). Praca na klatkę jest więc rzędu rozmiaru panelu,
+// niezależnie od rozmiaru świata.
+//
+// Kafelki pochodzą z piramidy liczników (od poziomu PYRAMID_FIRST_LEVEL w górę), aktualizowanej
+// przyrostowo z snap.changed: przeliczane są tylko kafelki ze zmienionymi komórkami i ich
+// przodkowie. Niższe poziomy (2x2, 4x4) liczy się wprost z komórek widocznego wycinka.
 class SimulationRenderer {
 public:
-    SimulationRenderer(Simulation& s);
+    static constexpr int PYRAMID_FIRST_LEVEL = 3; // kafelki 8x8
+
+    SimulationRenderer();
+
+    // Doprowadza piramidę i obraz wycinka `view` panelu o rozmiarze `panel` do stanu snap
+    // (snap.hasGrid musi być true). Przy tym samym widoku i kolejnym stanie poprawia tylko
+    // zmienione komórki; bez nowego stanu i zmiany widoku nic nie robi.
+    void update(const SimulationSnapshot& snap, const GridView& view, sf::Vector2f panel);
+
+    // update() dla widoku całej planszy i jeden sprite w celu (np. pomiar)
+    void draw(sf::RenderTarget& target, const SimulationSnapshot& snap);
 
-    void draw(sf::RenderTarget& target);
+    // Następny update() przebuduje piramidę i cały obraz
+    void invalidate() { drawnSequence = 0; pyramidSequence = 0; }
+
+    void setShading(TileShading s) { shading = s; }
+    TileShading getShading() const { return shading; }
+
+    bool hasImage() const { return image.cols > 0; }
+    const sf::Texture& texture() const { return viewTexture; }
+
+    // Gdzie i jak duży jest obraz względem lewego górnego rogu panelu (wystaje poza panel
+    // najwyżej o ułamek jednostki; rysujący przycina do panelu)
+    sf::IntRect imageRect() const { return { { 0, 0 }, { image.cols, image.rows } }; }
+    sf::Vector2f imagePosition() const { return image.position; }
+    sf::Vector2f imageSize() const { return image.size; }
+
+    int level() const { return image.level; }      // 0 = pojedyncze komórki
+    int lastUploadRows() const { return uploadRows; }
 
 private:
-    Simulation& sim;
-    float cellSize = 16.0f;
+    // Obraz w teksturze: poziom, pierwsza jednostka i liczba jednostek
+    struct ViewImage {
+        int level = 0;
+        int x0 = 0, y0 = 0;
+        int cols = 0, rows = 0;
+        sf::Vector2f position{ 0.0f, 0.0f };
+        sf::Vector2f size{ 0.0f, 0.0f };
+        TileShading shading = TileShading::MajorityType;
+
+        bool sameArea(const ViewImage& o) const {
+            return level == o.level && x0 == o.x0 && y0 == o.y0 && cols == o.cols && rows == o.rows && shading == o.shading;
+        }
+    };
+
+    ViewImage layout(const SimulationSnapshot& snap, const GridView& view, sf::Vector2f panel) const;
+
+    // Piramida: pełna przebudowa albo tylko kafelki ze zmienionymi komórkami
+    void updatePyramid(const SimulationSnapshot& snap);
+    TileCounts countCells(const SimulationSnapshot& snap, int x0, int y0, int size) const;
+    TileCounts tileCounts(const SimulationSnapshot& snap, int level, int tx, int ty) const;
+
+    // Wypełnia cały obraz albo tylko wiersze ze zmienionymi komórkami (poziom 0) i wysyła je
+    void fillRows(const SimulationSnapshot& snap, const std::vector<uint8_t>* onlyRows);
+
+    sf::Color cellColor(const SimulationSnapshot& snap, int idx) const {
+        return snap.alive[idx] ? palette[(int)snap.type[idx] * 2 + (int)snap.visualAction[idx]] : emptyColor;
+    }
+    sf::Color tileColor(const TileCounts& c, uint32_t cells) const;
+
+    // Kolor dla (typ, visualAction), żeby pętla po komórkach nie liczyła go od nowa
+    std::array<sf::Color, AGENT_TYPE_COUNT * 2> palette;
+    sf::Color emptyColor{ 60, 60, 60 }; // puste pole
+    TileShading shading = TileShading::MajorityType;
+
+    // Poziomy piramidy od PYRAMID_FIRST_LEVEL; flagi kafelków do przeliczenia na każdym poziomie
+    struct PyramidLevel {
+        int width = 0, height = 0; // w kafelkach
+        std::vector<TileCounts> tiles;
+        std::vector<uint8_t> dirty;
+    };
+    std::vector<PyramidLevel> pyramid;
+    int gridWidth = 0, gridHeight = 0;
+    uint64_t pyramidSequence = 0; // stan, do którego doprowadzono piramidę (0 = żaden)
+
+    std::vector<sf::Color> pixels; // image.cols * image.rows
+    std::vector<uint8_t> rowChanged;
+    sf::Texture viewTexture;
+    sf::Vector2u textureSize{ 0, 0 };
+    ViewImage image;
+    uint64_t drawnSequence = 0; // stan w obrazie (0 = żaden)
+    int uploadRows = 0;
 };
@@ -0,0 +1,42 @@
+﻿#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Kolejka o stałej pojemności dla jednego producenta i jednego konsumenta, bez blokad.
+// Producent pisze tylko `tail`, konsument tylko `head`; para release/acquire na indeksach
+// gwarantuje, że konsument widzi w pełni zapisany element. Capacity musi być potęgą dwójki.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity musi być potęgą dwójki");
+
+public:
+    // Producent: false, gdy kolejka jest pełna (element zostaje u wołającego)
+    bool push(T&& v) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity) return false;
+        slots[t & (Capacity - 1)] = std::move(v);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Konsument: false, gdy kolejka jest pusta
+    bool pop(T& out) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        out = std::move(slots[h & (Capacity - 1)]);
+        slots[h & (Capacity - 1)] = T{}; // zwalnia zasoby elementu od razu, nie przy nadpisaniu
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+private:
+    std::array<T, Capacity> slots{};
+
+    // Osobne linie pamięci, żeby producent i konsument nie unieważniali sobie nawzajem cache
+    alignas(64) std::atomic<size_t> head{ 0 };
+    alignas(64) std::atomic<size_t> tail{ 0 };
+};
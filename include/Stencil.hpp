@@ -0,0 +1,154 @@
+﻿#pragma once
+#include "Grid.hpp"
+#include <bit>
+#include <cstdint>
+
+// Stencile sąsiedztwa specjalizowane szablonami na NeighborhoodType i BoundaryMode.
+// Komórki wewnętrzne (~99% planszy) liczą sąsiadów stałymi przesunięciami idx + off[i]
+// bez mapowania brzegów i bez odczytu tablicy topologii; cienka ramka brzegowa korzysta
+// z tablicy Grid (albo z zawijania maską przy Periodic o wymiarach 2^k).
+// Wszystkie stencile zachowują kolejność slotów z Grid::getNeighborCoords.
+namespace Stencil {
+
+    template <NeighborhoodType N> struct Offsets;
+
+    template <> struct Offsets<NeighborhoodType::Moore> {
+        static constexpr int count = 8;
+        static constexpr int dx[8] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+        static constexpr int dy[8] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+        static constexpr int opposite[8] = { 7, 6, 5, 4, 3, 2, 1, 0 }; // slot (-dx, -dy)
+    };
+
+    template <> struct Offsets<NeighborhoodType::VonNeumann> {
+        static constexpr int count = 4;
+        static constexpr int dx[4] = { 1, -1, 0, 0 };
+        static constexpr int dy[4] = { 0, 0, 1, -1 };
+        static constexpr int opposite[4] = { 1, 0, 3, 2 };
+    };
+
+    // Komórka wewnętrzna: pełne sąsiedztwo, sąsiad = idx + stałe przesunięcie
+    template <NeighborhoodType N>
+    struct Interior {
+        using O = Offsets<N>;
+        int off[O::count];
+
+        explicit Interior(int width) {
+            for (int i = 0; i < O::count; ++i) off[i] = O::dy[i] * width + O::dx[i];
+        }
+
+        static constexpr int countAt(int) { return O::count; }
+        int neighbor(int idx, int i) const { return idx + off[i]; }
+        static constexpr int reverse(int, int i) { return O::opposite[i]; }
+    };
+
+    // Periodic przy szerokości i wysokości 2^k (>= 4): zawijanie maską zamiast modulo
+    template <NeighborhoodType N>
+    struct WrapPow2 {
+        using O = Offsets<N>;
+        int shift = 0, wmask = 0, hmask = 0;
+
+        WrapPow2(int width, int height)
+            : shift(std::countr_zero((unsigned)width)), wmask(width - 1), hmask(height - 1) {}
+
+        static constexpr int countAt(int) { return O::count; }
+        int neighbor(int idx, int i) const {
+            int x = idx & wmask;
+            int y = idx >> shift;
+            return (((y + O::dy[i]) & hmask) << shift) | ((x + O::dx[i]) & wmask);
+        }
+        static constexpr int reverse(int, int i) { return O::opposite[i]; }
+    };
+
+    // Dowolna komórka: tablica topologii (obsługuje duplikaty i sloty pochłonięte)
+    struct Table {
+        const Grid* grid;
+
+        int countAt(int idx) const { return grid->neighborCount(idx); }
+        int neighbor(int idx, int i) const { return grid->neighborsOf(idx)[i]; }
+        int reverse(int idx, int i) const { return grid->reverseSlotsOf(idx)[i]; }
+    };
+
+    // Widok siatki dla danej pary (sąsiedztwo, brzeg): dzieli wiersze na wnętrze i ramkę.
+    // Ciało dostaje (idx, stencil), gdzie stencil ma countAt/neighbor/reverse.
+    template <NeighborhoodType N, BoundaryMode B>
+    class View {
+    public:
+        // Przy Absorbing sąsiad z ramki ma skompaktowane sloty, więc stały slot zwrotny
+        // mają dopiero komórki 2 pola od krawędzi
+        static constexpr int margin = (B == BoundaryMode::Absorbing) ? 2 : 1;
+
+        explicit View(const Grid& g)
+            : width(g.width), height(g.height), interior(g.width), table{ &g }, wrap(g.width, g.height) {
+            usePow2 = (B == BoundaryMode::Periodic) &&
+                std::has_single_bit((unsigned)width) && std::has_single_bit((unsigned)height) &&
+                width >= 4 && height >= 4;
+        }
+
+        bool isInterior(int idx) const {
+            int x = idx % width;
+            int y = idx / width;
+            return x >= margin && x < width - margin && y >= margin && y < height - margin;
+        }
+
+        // Jedna komórka (np. w losowej kolejności albo z klasy kolorów); zwraca wynik ciała
+        template <class Body>
+        decltype(auto) visit(int idx, Body&& body) const {
+            if (isInterior(idx)) return body(idx, interior);
+            if constexpr (B == BoundaryMode::Periodic) {
+                if (usePow2) return body(idx, wrap);
+            }
+            return body(idx, table);
+        }
+
+        // Cały wiersz y od lewej do prawej: ramka, wnętrze, ramka
+        template <class Body>
+        void forRow(int y, Body&& body) const {
+            const int rowStart = y * width;
+            if (y < margin || y >= height - margin || width <= 2 * margin) {
+                border(rowStart, rowStart + width, body);
+                return;
+            }
+
+            border(rowStart, rowStart + margin, body);
+            for (int idx = rowStart + margin; idx < rowStart + width - margin; ++idx) {
+                body(idx, interior);
+            }
+            border(rowStart + width - margin, rowStart + width, body);
+        }
+
+    private:
+        int width, height;
+        Interior<N> interior;
+        Table table;
+        WrapPow2<N> wrap;
+        bool usePow2 = false;
+
+        template <class Body>
+        void border(int begin, int end, Body& body) const {
+            if constexpr (B == BoundaryMode::Periodic) {
+                if (usePow2) {
+                    for (int idx = begin; idx < end; ++idx) body(idx, wrap);
+                    return;
+                }
+            }
+            for (int idx = begin; idx < end; ++idx) body(idx, table);
+        }
+    };
+
+    template <NeighborhoodType N, class Fn>
+    void dispatchBoundary(const Grid& g, Fn&& fn) {
+        switch (g.boundary) {
+        case BoundaryMode::Periodic:   fn(View<N, BoundaryMode::Periodic>(g)); break;
+        case BoundaryMode::Fixed:      fn(View<N, BoundaryMode::Fixed>(g)); break;
+        case BoundaryMode::Reflective: fn(View<N, BoundaryMode::Reflective>(g)); break;
+        case BoundaryMode::Absorbing:  fn(View<N, BoundaryMode::Absorbing>(g)); break;
+        }
+    }
+
+    // Wybór specjalizacji raz na fazę: fn(view) z konkretnym View<N, B>
+    template <class Fn>
+    void dispatch(const Grid& g, Fn&& fn) {
+        if (g.neighborhood == NeighborhoodType::Moore) dispatchBoundary<NeighborhoodType::Moore>(g, fn);
+        else dispatchBoundary<NeighborhoodType::VonNeumann>(g, fn);
+    }
+}
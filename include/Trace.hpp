@@ -0,0 +1,58 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Opcjonalny ślad wykonania (Chrome trace JSON, do otwarcia w Perfetto / chrome://tracing).
+// Każdy wątek pisze zdarzenia do własnego bufora o stałej pojemności, bez blokad;
+// bufor jest rejestrowany przy pierwszym zdarzeniu wątku w sesji nagrywania.
+// Gdy nagrywanie jest wyłączone, Scope kosztuje jeden odczyt atomowej flagi.
+namespace Trace {
+    // Domyślna pojemność bufora jednego wątku (zdarzenia ponad nią są liczone i odrzucane)
+    static constexpr size_t DEFAULT_EVENTS_PER_THREAD = size_t(1) << 18;
+
+    namespace detail {
+        extern std::atomic<bool> recording;
+        int64_t now();
+        void record(const char* name, int64_t begin, int64_t end);
+    }
+
+    inline bool active() { return detail::recording.load(std::memory_order_relaxed); }
+
+    // Rozpoczyna nową sesję (czyści poprzednie zdarzenia) i rejestruje bieżący wątek oraz
+    // wątki jego zespołu OpenMP, żeby pierwsze pokolenie nie alokowało buforów w trakcie step().
+    // Wołać z wątku, który liczy pokolenia, gdy żaden inny wątek nie wykonuje symulacji.
+    void start(size_t eventsPerThread = DEFAULT_EVENTS_PER_THREAD);
+    void stop();
+
+    // Nazwa bieżącego wątku na osi czasu (domyślnie "OpenMP n" / "Wątek n")
+    void setThreadName(const char* name);
+
+    // Liczba zdarzeń w buforach i odrzuconych z braku miejsca
+    size_t eventCount();
+    size_t droppedCount();
+
+    // Zapis w formacie Chrome trace JSON; wołać po stop() (zdarzenia w locie mogą nie trafić)
+    bool writeChromeJson(const std::string& path, std::string& error);
+
+    // Przedział czasu od konstrukcji do end() albo destrukcji; name musi żyć do zapisu (literał)
+    class Scope {
+    public:
+        explicit Scope(const char* n) : name(active() ? n : nullptr), begin(name ? detail::now() : 0) {}
+        ~Scope() { end(); }
+
+        void end() {
+            if (!name) return;
+            detail::record(name, begin, detail::now());
+            name = nullptr;
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* name;
+        int64_t begin;
+    };
+}
@@ -0,0 +1,90 @@
+#include "AgentStore.hpp"
+#include <algorithm>
+#include <atomic>
+
+void AgentStore::resize(int cells) {
+    alive.assign(cells, 0);
+    id.assign(cells, -1);
+    type.assign(cells, AgentType::AlwaysCooperate);
+    currentAction.assign(cells, Action::Cooperate);
+    lastAction.assign(cells, Action::Cooperate);
+    visualAction.assign(cells, Action::Cooperate);
+    payoff.assign(cells, 0.0f);
+    lastPayoff.assign(cells, 0.0f);
+    reputation.assign(cells, 0.5f);
+    strategyAge.assign(cells, 0);
+    memorySize.assign(cells, 0);
+    partnerId.assign((size_t)cells * MaxNeighbors, -1);
+    myLastBits.assign(cells, 0);
+    theirLastBits.assign(cells, 0);
+    nextId = 0;
+    markAllChanged();
+}
+
+void AgentStore::spawn(int idx, AgentType t, int neighborsCount) {
+    spawnWithId(idx, t, neighborsCount, nextId++);
+}
+
+void AgentStore::spawnWithId(int idx, AgentType t, int neighborsCount, int newId) {
+    alive[idx] = 1;
+    id[idx] = newId;
+    type[idx] = t;
+    currentAction[idx] = Action::Cooperate;
+    lastAction[idx] = Action::Cooperate;
+    visualAction[idx] = Action::Cooperate;
+    payoff[idx] = 0.0f;
+    lastPayoff[idx] = 0.0f;
+    reputation[idx] = 0.5f;
+    strategyAge[idx] = 0;
+    resetMemory(idx, neighborsCount);
+    markChanged(idx);
+}
+
+void AgentStore::kill(int idx) {
+    alive[idx] = 0;
+    id[idx] = -1;
+    markChanged(idx);
+}
+
+void AgentStore::move(int from, int to) {
+    alive[to] = 1;
+    id[to] = id[from];
+    type[to] = type[from];
+    currentAction[to] = currentAction[from];
+    lastAction[to] = lastAction[from];
+    visualAction[to] = visualAction[from];
+    payoff[to] = payoff[from];
+    lastPayoff[to] = lastPayoff[from];
+    reputation[to] = reputation[from];
+    strategyAge[to] = strategyAge[from];
+    memorySize[to] = memorySize[from];
+    std::copy_n(partnersOf(from), MaxNeighbors, partnersOf(to));
+    myLastBits[to] = myLastBits[from];
+    theirLastBits[to] = theirLastBits[from];
+    markChanged(to);
+
+    kill(from);
+}
+
+void AgentStore::resetMemory(int idx, int neighborsCount) {
+    memorySize[idx] = (uint8_t)std::min(neighborsCount, MaxNeighbors);
+    std::fill_n(partnersOf(idx), MaxNeighbors, -1);
+    myLastBits[idx] = 0;
+    theirLastBits[idx] = 0;
+}
+
+void AgentStore::markChanged(int idx) {
+    // Najpierw zwykły odczyt: bit bywa już ustawiony (nikt nie czyści go bez GUI), a wtedy
+    // omijamy zapis, który przerzucałby linię pamięci między wątkami
+    std::atomic_ref<uint64_t> word(changed[idx >> 6]);
+    const uint64_t bit = 1ull << (idx & 63);
+    if (!(word.load(std::memory_order_relaxed) & bit)) word.fetch_or(bit, std::memory_order_relaxed);
+}
+
+void AgentStore::markAllChanged() {
+    changed.assign((alive.size() + 63) / 64, ~0ull);
+}
+
+void AgentStore::clearChanged() {
+    std::fill(changed.begin(), changed.end(), 0);
+}
@@ -0,0 +1,57 @@
+#include "AllocationCounter.hpp"
+
+#ifdef SOCIALEVO_COUNT_ALLOCATIONS
+#include <cstdlib>
+#include <new>
+
+static thread_local uint64_t allocations = 0;
+
+uint64_t AllocationCounter::threadCount() {
+    return allocations;
+}
+
+uint64_t AllocationCounter::teamCount() {
+    // Każdy wątek zespołu dodaje swój licznik (wątek wołający jest wątkiem 0 zespołu)
+    uint64_t total = 0;
+#pragma omp parallel reduction(+:total)
+    total += allocations;
+    return total;
+}
+
+void* operator new(std::size_t size) {
+    allocations++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    allocations++;
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return ::operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+#else
+
+uint64_t AllocationCounter::threadCount() {
+    return 0;
+}
+
+uint64_t AllocationCounter::teamCount() {
+    return 0;
+}
+
+#endif
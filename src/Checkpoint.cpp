@@ -0,0 +1,516 @@
+#include "Checkpoint.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SOCIALEVO_CHECKPOINT_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+    constexpr char MAGIC[8] = { 'S', 'E', 'V', 'O', 'C', 'K', 'P', 'T' };
+    constexpr uint32_t ENDIAN_TAG = 0x01020304u;
+
+    // Górna granica pojemności historii wykresów z pliku (chroni przed ogromną alokacją)
+    constexpr uint64_t MAX_HISTORY_CAPACITY = 1ull << 24;
+
+    constexpr uint32_t fourcc(const char (&s)[5]) {
+        return (uint32_t)(uint8_t)s[0] | ((uint32_t)(uint8_t)s[1] << 8) | ((uint32_t)(uint8_t)s[2] << 16) | ((uint32_t)(uint8_t)s[3] << 24);
+    }
+
+    // Tagi sekcji (odczyt szuka po tagu, więc kolejność w pliku nie jest wymagana)
+    enum Section : uint32_t {
+        PARAMS = fourcc("PARM"),
+        ALLOWED_TYPES = fourcc("ATYP"),
+        ALIVE = fourcc("ALIV"),
+        ID = fourcc("ID  "),
+        TYPE = fourcc("TYPE"),
+        CURRENT_ACTION = fourcc("CACT"),
+        LAST_ACTION = fourcc("LACT"),
+        VISUAL_ACTION = fourcc("VACT"),
+        PAYOFF = fourcc("PAY "),
+        LAST_PAYOFF = fourcc("LPAY"),
+        REPUTATION = fourcc("REPU"),
+        STRATEGY_AGE = fourcc("SAGE"),
+        MEMORY_SIZE = fourcc("MSIZ"),
+        PARTNER_ID = fourcc("PART"),
+        MY_LAST_BITS = fourcc("MYLB"),
+        THEIR_LAST_BITS = fourcc("THLB"),
+        LAST_METRICS = fourcc("LMET"),
+        HISTORY = fourcc("HIST")
+    };
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t endianTag;
+        uint32_t sectionCount;
+        uint32_t reserved;
+        uint64_t fileSize;
+    };
+
+    struct SectionHeader {
+        uint32_t tag;
+        uint32_t elemSize;
+        uint64_t count;
+    };
+
+    // Parametry modelu i siatki; stały układ bez dziur (zmiana = nowa VERSION)
+    struct Params {
+        int32_t width, height;
+        uint8_t boundary, neighborhood, mode, updateRule;
+        uint8_t migrationScheduling, birthScheduling, normalizePayoff, strategyFlags;
+        float R, T, S, P;
+        float density, moveProb, moveEpsilon;
+        float reputationAlpha, reputationThreshold;
+        float reproductionProb, deathProb, selectionBeta;
+        float mutationRate, fermiK;
+        int32_t roundsPerGeneration, generation, nextId, reserved;
+        uint64_t seed;
+        uint64_t historyCapacity;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Params> && sizeof(Params) == 104, "układ Params jest częścią formatu");
+    static_assert(sizeof(FileHeader) == 32 && sizeof(SectionHeader) == 16, "układ nagłówków jest częścią formatu");
+    static_assert(std::is_trivially_copyable_v<MetricsSample>, "MetricsSample zapisywany blokowo");
+
+    constexpr size_t ALIGN = 8;
+
+    size_t padded(size_t bytes) { return (bytes + ALIGN - 1) / ALIGN * ALIGN; }
+
+    class Writer {
+    public:
+        explicit Writer(std::ofstream& f) : out(f) {}
+
+        void section(uint32_t tag, const void* data, size_t elemSize, size_t count) {
+            SectionHeader h{ tag, (uint32_t)elemSize, (uint64_t)count };
+            out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+            const size_t bytes = elemSize * count;
+            if (bytes) out.write(static_cast<const char*>(data), (std::streamsize)bytes);
+
+            static constexpr std::array<char, ALIGN> zeros{};
+            out.write(zeros.data(), (std::streamsize)(padded(bytes) - bytes));
+            sections++;
+        }
+
+        template <class T>
+        void section(uint32_t tag, const std::vector<T>& v) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            section(tag, v.data(), sizeof(T), v.size());
+        }
+
+        uint32_t sections = 0;
+
+    private:
+        std::ofstream& out;
+    };
+
+    // Cały plik w pamięci: mapowanie (POSIX) albo zwykły odczyt do bufora
+    class FileView {
+    public:
+        ~FileView() {
+#ifdef SOCIALEVO_CHECKPOINT_MMAP
+            if (mapped) munmap(mapped, length);
+#endif
+        }
+
+        bool open(const std::string& path, std::string& error) {
+#ifdef SOCIALEVO_CHECKPOINT_MMAP
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                error = "nie można otworzyć '" + path + "'";
+                return false;
+            }
+
+            struct stat st {};
+            if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+                ::close(fd);
+                error = "pusty albo nieczytelny plik '" + path + "'";
+                return false;
+            }
+
+            length = (size_t)st.st_size;
+            void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd); // mapowanie trzyma plik samo
+
+            if (p == MAP_FAILED) {
+                error = "mmap nie powiódł się dla '" + path + "'";
+                return false;
+            }
+            madvise(p, length, MADV_SEQUENTIAL);
+            mapped = p;
+            bytes = static_cast<const uint8_t*>(p);
+            return true;
+#else
+            std::ifstream in(path, std::ios::binary | std::ios::ate);
+            if (!in) {
+                error = "nie można otworzyć '" + path + "'";
+                return false;
+            }
+            length = (size_t)in.tellg();
+            buffer.resize(length);
+            in.seekg(0);
+            if (!in.read(reinterpret_cast<char*>(buffer.data()), (std::streamsize)length)) {
+                error = "błąd odczytu '" + path + "'";
+                return false;
+            }
+            bytes = buffer.data();
+            return true;
+#endif
+        }
+
+        const uint8_t* data() const { return bytes; }
+        size_t size() const { return length; }
+
+    private:
+        const uint8_t* bytes = nullptr;
+        size_t length = 0;
+#ifdef SOCIALEVO_CHECKPOINT_MMAP
+        void* mapped = nullptr;
+#else
+        std::vector<uint8_t> buffer;
+#endif
+    };
+
+    struct SectionView {
+        const uint8_t* data = nullptr;
+        uint32_t elemSize = 0;
+        uint64_t count = 0;
+    };
+
+    class Reader {
+    public:
+        std::vector<std::pair<uint32_t, SectionView>> sections;
+        std::string error;
+
+        const SectionView* find(uint32_t tag) const {
+            for (const auto& [t, view] : sections) {
+                if (t == tag) return &view;
+            }
+            return nullptr;
+        }
+
+        // Sekcja o dokładnie takim rozmiarze elementu i liczbie elementów
+        const SectionView* require(uint32_t tag, size_t elemSize, uint64_t count, const char* what) {
+            const SectionView* s = find(tag);
+            if (!s) {
+                error = std::string("brak sekcji ") + what;
+                return nullptr;
+            }
+            if (s->elemSize != elemSize || s->count != count) {
+                error = std::string("niezgodny rozmiar sekcji ") + what;
+                return nullptr;
+            }
+            return s;
+        }
+    };
+
+    template <class T>
+    void copyInto(std::vector<T>& dst, const SectionView& s) {
+        dst.resize((size_t)s.count);
+        if (s.count) std::memcpy(dst.data(), s.data, (size_t)s.count * sizeof(T));
+    }
+
+    // Bajty wyliczeń w zakresie (zły plik nie może dać wartości spoza enuma)
+    bool allBelow(const SectionView& s, uint8_t limit) {
+        for (uint64_t i = 0; i < s.count; ++i) {
+            if (s.data[i] >= limit) return false;
+        }
+        return true;
+    }
+}
+
+bool Checkpoint::save(const Simulation& sim, const std::string& path, std::string& error) {
+    const AgentStore& a = sim.agents;
+    const size_t cells = (size_t)sim.grid.cellCount();
+
+    if ((size_t)a.size() != cells) {
+        error = "stan agentów nie pasuje do wymiarów siatki (potrzebny reset)";
+        return false;
+    }
+
+    Params p{};
+    p.width = sim.grid.width;
+    p.height = sim.grid.height;
+    p.boundary = (uint8_t)sim.grid.boundary;
+    p.neighborhood = (uint8_t)sim.grid.neighborhood;
+    p.mode = (uint8_t)sim.mode;
+    p.updateRule = (uint8_t)sim.updateRule;
+    p.migrationScheduling = (uint8_t)sim.migrationScheduling;
+    p.birthScheduling = (uint8_t)sim.birthScheduling;
+    p.normalizePayoff = sim.normalizePayoff ? 1 : 0;
+    p.strategyFlags = (uint8_t)((sim.useAlwaysCooperate ? 1 : 0) | (sim.useAlwaysDefect ? 2 : 0) | (sim.useTitForTat ? 4 : 0)
+        | (sim.usePavlov ? 8 : 0) | (sim.useDiscriminator ? 16 : 0));
+    p.R = sim.matrix.R;
+    p.T = sim.matrix.T;
+    p.S = sim.matrix.S;
+    p.P = sim.matrix.P;
+    p.density = sim.density;
+    p.moveProb = sim.moveProb;
+    p.moveEpsilon = sim.moveEpsilon;
+    p.reputationAlpha = sim.reputationAlpha;
+    p.reputationThreshold = sim.reputationThreshold;
+    p.reproductionProb = sim.reproductionProb;
+    p.deathProb = sim.deathProb;
+    p.selectionBeta = sim.selectionBeta;
+    p.mutationRate = sim.mutationRate;
+    p.fermiK = sim.fermiK;
+    p.roundsPerGeneration = sim.roundsPerGeneration;
+    p.generation = sim.generation;
+    p.nextId = a.nextId;
+    p.seed = sim.seed;
+    p.historyCapacity = sim.history.capacity();
+
+    std::vector<MetricsSample> history(sim.history.size());
+    for (size_t i = 0; i < history.size(); ++i) history[i] = sim.history[i];
+
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            error = "nie można utworzyć '" + tmpPath + "'";
+            return false;
+        }
+
+        // Nagłówek uzupełniany na końcu (liczba sekcji i rozmiar pliku)
+        FileHeader header{};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        Writer w(out);
+        w.section(PARAMS, &p, sizeof(p), 1);
+        w.section(ALLOWED_TYPES, sim.allowedTypes);
+        w.section(ALIVE, a.alive);
+        w.section(ID, a.id);
+        w.section(TYPE, a.type);
+        w.section(CURRENT_ACTION, a.currentAction);
+        w.section(LAST_ACTION, a.lastAction);
+        w.section(VISUAL_ACTION, a.visualAction);
+        w.section(PAYOFF, a.payoff);
+        w.section(LAST_PAYOFF, a.lastPayoff);
+        w.section(REPUTATION, a.reputation);
+        w.section(STRATEGY_AGE, a.strategyAge);
+        w.section(MEMORY_SIZE, a.memorySize);
+        w.section(PARTNER_ID, a.partnerId);
+        w.section(MY_LAST_BITS, a.myLastBits);
+        w.section(THEIR_LAST_BITS, a.theirLastBits);
+        w.section(LAST_METRICS, &sim.lastMetrics, sizeof(MetricsSample), 1);
+        w.section(HISTORY, history);
+
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.endianTag = ENDIAN_TAG;
+        header.sectionCount = w.sections;
+        header.fileSize = (uint64_t)out.tellp();
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        if (!out.flush()) {
+            error = "błąd zapisu do '" + tmpPath + "'";
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        error = "nie można podmienić '" + path + "': " + ec.message();
+        return false;
+    }
+    return true;
+}
+
+bool Checkpoint::load(Simulation& sim, const std::string& path, std::string& error) {
+    FileView file;
+    if (!file.open(path, error)) return false;
+
+    const uint8_t* base = file.data();
+    const size_t size = file.size();
+
+    FileHeader header{};
+    if (size < sizeof(header)) {
+        error = "plik za krótki na punkt kontrolny";
+        return false;
+    }
+    std::memcpy(&header, base, sizeof(header));
+
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        error = "to nie jest plik punktu kontrolnego";
+        return false;
+    }
+    if (header.endianTag != ENDIAN_TAG) {
+        error = "punkt kontrolny z maszyny o innej kolejności bajtów";
+        return false;
+    }
+    if (header.version != VERSION) {
+        error = "nieobsługiwana wersja punktu kontrolnego " + std::to_string(header.version) + " (oczekiwano " + std::to_string(VERSION) + ")";
+        return false;
+    }
+    if (header.fileSize != size) {
+        error = "plik punktu kontrolnego jest ucięty";
+        return false;
+    }
+
+    // Spis sekcji (wskaźniki do zmapowanego pliku, bez kopiowania)
+    Reader r;
+    size_t offset = sizeof(header);
+    for (uint32_t i = 0; i < header.sectionCount; ++i) {
+        SectionHeader sh{};
+        if (size - offset < sizeof(sh)) {
+            error = "uszkodzony spis sekcji";
+            return false;
+        }
+        std::memcpy(&sh, base + offset, sizeof(sh));
+        offset += sizeof(sh);
+
+        if (sh.elemSize == 0 || sh.count > (size - offset) / sh.elemSize) {
+            error = "sekcja wychodzi poza plik";
+            return false;
+        }
+        const size_t bytes = (size_t)(sh.count * sh.elemSize);
+        r.sections.push_back({ sh.tag, SectionView{ base + offset, sh.elemSize, sh.count } });
+        offset += std::min(padded(bytes), size - offset);
+    }
+
+    // Najpierw sprawdzamy wszystko, dopiero potem nadpisujemy symulację
+    const SectionView* params = r.require(PARAMS, sizeof(Params), 1, "parametrów");
+    if (!params) {
+        error = r.error;
+        return false;
+    }
+    Params p{};
+    std::memcpy(&p, params->data, sizeof(p));
+
+    if (p.width <= 0 || p.height <= 0 || (int64_t)p.width * p.height > (int64_t)INT32_MAX / AgentStore::MaxNeighbors
+        || p.boundary > (uint8_t)BoundaryMode::Absorbing || p.neighborhood > (uint8_t)NeighborhoodType::VonNeumann
+        || p.mode > (uint8_t)EvolutionMode::DeathBirth || p.updateRule > (uint8_t)UpdateRule::Fermi
+        || p.migrationScheduling > (uint8_t)UpdateScheduling::Parallel || p.birthScheduling > (uint8_t)UpdateScheduling::Parallel) {
+        error = "niepoprawne parametry w punkcie kontrolnym";
+        return false;
+    }
+
+    const uint64_t cells = (uint64_t)p.width * (uint64_t)p.height;
+    const uint8_t typeLimit = (uint8_t)AgentType::Discriminator + 1;
+
+    struct Expected {
+        uint32_t tag;
+        size_t elemSize;
+        uint64_t count;
+        const char* what;
+    };
+    const Expected expected[] = {
+        { ALIVE, sizeof(uint8_t), cells, "alive" },
+        { ID, sizeof(int), cells, "id" },
+        { TYPE, sizeof(AgentType), cells, "type" },
+        { CURRENT_ACTION, sizeof(Action), cells, "currentAction" },
+        { LAST_ACTION, sizeof(Action), cells, "lastAction" },
+        { VISUAL_ACTION, sizeof(Action), cells, "visualAction" },
+        { PAYOFF, sizeof(float), cells, "payoff" },
+        { LAST_PAYOFF, sizeof(float), cells, "lastPayoff" },
+        { REPUTATION, sizeof(float), cells, "reputation" },
+        { STRATEGY_AGE, sizeof(int), cells, "strategyAge" },
+        { MEMORY_SIZE, sizeof(uint8_t), cells, "memorySize" },
+        { PARTNER_ID, sizeof(int32_t), cells * AgentStore::MaxNeighbors, "partnerId" },
+        { MY_LAST_BITS, sizeof(uint8_t), cells, "myLastBits" },
+        { THEIR_LAST_BITS, sizeof(uint8_t), cells, "theirLastBits" },
+        { LAST_METRICS, sizeof(MetricsSample), 1, "lastMetrics" }
+    };
+    for (const Expected& e : expected) {
+        if (!r.require(e.tag, e.elemSize, e.count, e.what)) {
+            error = r.error;
+            return false;
+        }
+    }
+
+    const SectionView* allowed = r.find(ALLOWED_TYPES);
+    const SectionView* history = r.find(HISTORY);
+    if (!allowed || allowed->elemSize != sizeof(AgentType) || allowed->count == 0 || !allBelow(*allowed, typeLimit)
+        || !history || history->elemSize != sizeof(MetricsSample) || history->count > p.historyCapacity
+        || p.historyCapacity > MAX_HISTORY_CAPACITY) {
+        error = "niepoprawna lista typów albo historia metryk";
+        return false;
+    }
+
+    if (!allBelow(*r.find(TYPE), typeLimit) || !allBelow(*r.find(CURRENT_ACTION), 2) || !allBelow(*r.find(LAST_ACTION), 2)
+        || !allBelow(*r.find(VISUAL_ACTION), 2) || !allBelow(*r.find(MEMORY_SIZE), AgentStore::MaxNeighbors + 1)) {
+        error = "niepoprawne wartości w tablicach agentów";
+        return false;
+    }
+
+    // Historię składamy, zanim cokolwiek w symulacji się zmieni: jej pojemność pochodzi wprost
+    // z pliku (tablice agentów ogranicza rozmiar pliku), więc bad_alloc nie zostawi połowy stanu
+    RingBuffer<MetricsSample> restoredHistory((size_t)p.historyCapacity);
+    for (uint64_t i = 0; i < history->count; ++i) {
+        MetricsSample m;
+        std::memcpy(&m, history->data + i * sizeof(MetricsSample), sizeof(MetricsSample));
+        restoredHistory.push_back(m);
+    }
+
+    // Parametry
+    sim.grid.width = p.width;
+    sim.grid.height = p.height;
+    sim.grid.boundary = (BoundaryMode)p.boundary;
+    sim.grid.neighborhood = (NeighborhoodType)p.neighborhood;
+    sim.mode = (EvolutionMode)p.mode;
+    sim.updateRule = (UpdateRule)p.updateRule;
+    sim.migrationScheduling = (UpdateScheduling)p.migrationScheduling;
+    sim.birthScheduling = (UpdateScheduling)p.birthScheduling;
+    sim.normalizePayoff = p.normalizePayoff != 0;
+    sim.useAlwaysCooperate = (p.strategyFlags & 1) != 0;
+    sim.useAlwaysDefect = (p.strategyFlags & 2) != 0;
+    sim.useTitForTat = (p.strategyFlags & 4) != 0;
+    sim.usePavlov = (p.strategyFlags & 8) != 0;
+    sim.useDiscriminator = (p.strategyFlags & 16) != 0;
+    sim.matrix = { p.R, p.T, p.S, p.P };
+    sim.density = p.density;
+    sim.moveProb = p.moveProb;
+    sim.moveEpsilon = p.moveEpsilon;
+    sim.reputationAlpha = p.reputationAlpha;
+    sim.reputationThreshold = p.reputationThreshold;
+    sim.reproductionProb = p.reproductionProb;
+    sim.deathProb = p.deathProb;
+    sim.selectionBeta = p.selectionBeta;
+    sim.mutationRate = p.mutationRate;
+    sim.fermiK = p.fermiK;
+    sim.roundsPerGeneration = p.roundsPerGeneration;
+    sim.generation = p.generation;
+    sim.seed = p.seed;
+    copyInto(sim.allowedTypes, *allowed);
+
+    // Agenci
+    AgentStore& a = sim.agents;
+    copyInto(a.alive, *r.find(ALIVE));
+    copyInto(a.id, *r.find(ID));
+    copyInto(a.type, *r.find(TYPE));
+    copyInto(a.currentAction, *r.find(CURRENT_ACTION));
+    copyInto(a.lastAction, *r.find(LAST_ACTION));
+    copyInto(a.visualAction, *r.find(VISUAL_ACTION));
+    copyInto(a.payoff, *r.find(PAYOFF));
+    copyInto(a.lastPayoff, *r.find(LAST_PAYOFF));
+    copyInto(a.reputation, *r.find(REPUTATION));
+    copyInto(a.strategyAge, *r.find(STRATEGY_AGE));
+    copyInto(a.memorySize, *r.find(MEMORY_SIZE));
+    copyInto(a.partnerId, *r.find(PARTNER_ID));
+    copyInto(a.myLastBits, *r.find(MY_LAST_BITS));
+    copyInto(a.theirLastBits, *r.find(THEIR_LAST_BITS));
+    a.nextId = p.nextId;
+    a.markAllChanged(); // wczytana plansza jest w całości nowa dla wyświetlania
+
+    // Metryki
+    std::memcpy(&sim.lastMetrics, r.find(LAST_METRICS)->data, sizeof(MetricsSample));
+    sim.historyMax = (size_t)p.historyCapacity;
+    sim.history = std::move(restoredHistory);
+
+    sim.grid.updateTopology();
+    sim.recountPopulation(); // liczniki przyrostowe nie są częścią pliku
+    return true;
+}
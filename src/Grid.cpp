@@ -1,4 +1,5 @@
 #include "Grid.hpp"
+#include <algorithm>
 
 static int clampInt(int v, int lo, int hi) {
     if (v < lo) return lo;
@@ -21,24 +22,12 @@ static int reflectIndex(int v, int m) {
 }
 
 Grid::Grid(int w, int h)
-    : width(w), height(h), agents(w* h, nullptr) {}
-
-Agent*& Grid::get(int x, int y) {
-    return agents[y * width + x];
-}
-
-const Agent* Grid::get(int x, int y) const {
-    return agents[y * width + x];
-}
+    : width(w), height(h) {}
 
 bool Grid::inBounds(int x, int y) const {
     return (x >= 0 && x < width&& y >= 0 && y < height);
 }
 
-bool Grid::isEmpty(int x, int y) const {
-    return get(x, y) == nullptr;
-}
-
 int Grid::mapX(int x) const {
     switch (boundary) {
     case BoundaryMode::Periodic:   return modWrap(x, width);
@@ -101,8 +90,96 @@ std::vector<std::pair<int, int>> Grid::getNeighborCoords(int x, int y) const {
     return out;
 }
 
-void Grid::clear() {
-    std::fill(agents.begin(), agents.end(), nullptr);
+void Grid::updateTopology() {
+    if (topoWidth == width && topoHeight == height &&
+        topoBoundary == boundary && topoNeighborhood == neighborhood &&
+        !neighborTable.empty()) {
+        return;
+    }
+
+    topoStride = (neighborhood == NeighborhoodType::Moore) ? 8 : 4;
+    const int cells = width * height;
+
+    neighborTable.assign((size_t)cells * topoStride, -1);
+    neighborCounts.assign(cells, 0);
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            int idx = y * width + x;
+            int32_t* row = neighborTable.data() + (size_t)idx * topoStride;
+
+            // Budowa tablicy to rzadka operacja, więc korzystamy ze starej ścieżki
+            auto coords = getNeighborCoords(x, y);
+            for (size_t i = 0; i < coords.size(); ++i) {
+                row[i] = coords[i].second * width + coords[i].first;
+            }
+            neighborCounts[idx] = (uint8_t)coords.size();
+        }
+    }
+
+    // Krawędzie zwrotne (parowanie kolejnych wystąpień, żeby duplikaty się nie sklejały)
+    reverseTable.assign((size_t)cells * topoStride, -1);
+
+    for (int idx = 0; idx < cells; ++idx) {
+        const int32_t* row = neighborsOf(idx);
+        int8_t* rev = reverseTable.data() + (size_t)idx * topoStride;
+
+        for (int i = 0; i < neighborCounts[idx]; ++i) {
+            int n = row[i];
+
+            int occurrence = 0;
+            for (int j = 0; j < i; ++j) {
+                if (row[j] == n) occurrence++;
+            }
+
+            const int32_t* nRow = neighborsOf(n);
+            for (int j = 0; j < neighborCounts[n]; ++j) {
+                if (nRow[j] != idx) continue;
+                if (occurrence-- == 0) {
+                    rev[i] = (int8_t)j;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Kolorowanie: forbidden[c] ma bity kolorów zajętych przez sąsiadów w obie strony
+    // (przy Reflective/Fixed lista sąsiadów nie musi być symetryczna)
+    std::vector<uint32_t> forbidden(cells, 0);
+    std::vector<uint8_t> color(cells, 0);
+    int colors = 0;
+
+    for (int idx = 0; idx < cells; ++idx) {
+        const int32_t* row = neighborsOf(idx);
+        uint32_t mask = forbidden[idx];
+        for (int i = 0; i < neighborCounts[idx]; ++i) {
+            int n = row[i];
+            if (n < idx) mask |= 1u << color[n];
+        }
+
+        int c = 0;
+        while (mask & (1u << c)) c++;
+        color[idx] = (uint8_t)c;
+        colors = std::max(colors, c + 1);
+
+        for (int i = 0; i < neighborCounts[idx]; ++i) {
+            int n = row[i];
+            if (n > idx) forbidden[n] |= 1u << c;
+        }
+    }
+
+    colorStart.assign(colors + 1, 0);
+    for (int idx = 0; idx < cells; ++idx) colorStart[color[idx] + 1]++;
+    for (int c = 0; c < colors; ++c) colorStart[c + 1] += colorStart[c];
+
+    colorOrder.resize(cells);
+    std::vector<int32_t> fill(colorStart.begin(), colorStart.end() - 1);
+    for (int idx = 0; idx < cells; ++idx) colorOrder[fill[color[idx]]++] = idx;
+
+    topoWidth = width;
+    topoHeight = height;
+    topoBoundary = boundary;
+    topoNeighborhood = neighborhood;
 }
 
 
@@ -1,9 +1,21 @@
 #include "GuiPanel.hpp"
+#include "Checkpoint.hpp"
 #include "constants.hpp"
+#include "Trace.hpp"
+#include <cstdio>
 
-GuiPanel::GuiPanel(Simulation& s, bool& r) : sim(s), running(r) {}
+GuiPanel::GuiPanel(SimulationController& c) : controller(c) {
+    controller.exclusive([&](Simulation& sim) { params = SimulationParams::capture(sim); });
+    sentParams = params;
+}
 
-void GuiPanel::update(sf::RenderWindow& win, LeftPanelMode& leftMode) {
+void GuiPanel::sendParams() {
+    if (params == sentParams) return;
+    controller.post([p = params](Simulation& sim) { p.applyTo(sim); });
+    sentParams = params;
+}
+
+void GuiPanel::update(sf::RenderWindow& win, LeftPanelMode& leftMode, const SimulationSnapshot& snap) {
 
     // Używamy stałych z constants.hpp dla spójności
     float startX = (float)LEFT_PANEL_WIDTH;
@@ -32,8 +44,11 @@ void GuiPanel::update(sf::RenderWindow& win, LeftPanelMode& leftMode) {
 
     // Przyciski obok siebie
     float availWidth = ImGui::GetContentRegionAvail().x;
+    const bool running = controller.running();
     if (ImGui::Button(running ? "PAUZA" : "START", ImVec2(availWidth * 0.33f - 5.f, 0.0f))) {
-        running = !running;
+        sendParams();
+        controller.setRunning(!running);
+        if (running) controller.post([](Simulation& sim) { sim.flushCsvFile(); }); // po pauzie plik CSV jest kompletny
     }
 
     // Tooltip dla przycisku start
@@ -42,7 +57,8 @@ void GuiPanel::update(sf::RenderWindow& win, LeftPanelMode& leftMode) {
     ImGui::SameLine(); // Następny element w tej samej linii
 
     if (ImGui::Button("KROK +1", ImVec2(availWidth * 0.33f - 5.f, 0.0f))) {
-        sim.step();
+        sendParams();
+        controller.post([](Simulation& sim) { sim.step(); });
     }
 
     ImGui::SameLine();
@@ -51,8 +67,10 @@ void GuiPanel::update(sf::RenderWindow& win, LeftPanelMode& leftMode) {
     ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.8f, 0.2f, 0.2f, 1.0f));
     ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(1.0f, 0.3f, 0.3f, 1.0f));
     if (ImGui::Button("RESET", ImVec2(availWidth * 0.33f - 5.f, 0.0f))) {
-        sim.reset();
-        running = false;
+        controller.setRunning(false);
+        params.seed = Simulation::randomSeed();
+        sendParams();
+        controller.post([](Simulation& sim) { sim.reset(); });
     }
     ImGui::PopStyleColor(2);
     if (ImGui::IsItemHovered()) ImGui::SetTooltip("Restartuje symulację z nowymi ustawieniami populacji");
@@ -60,8 +78,33 @@ void GuiPanel::update(sf::RenderWindow& win, LeftPanelMode& leftMode) {
     ImGui::Dummy(ImVec2(0.0f, 5.0f)); // Odstęp pionowy
 
     // Statystyki na żywo
-    ImGui::TextColored(ImVec4(0.5f, 0.8f, 1.0f, 1.0f), "Generacja: %d", sim.generation);
-    ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "Kooperacja: %.2f%%", sim.cooperationRate() * 100.f);
+    ImGui::TextColored(ImVec4(0.5f, 0.8f, 1.0f, 1.0f), "Generacja: %d", snap.generation);
+    ImGui::SameLine();
+    ImGui::TextDisabled("(%.0f pokoleń/s)", snap.generationsPerSecond);
+    ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "Kooperacja: %.2f%%", snap.cooperationRate * 100.f);
+
+    bool threaded = controller.threaded();
+    if (ImGui::Checkbox("Osobny wątek symulacji", &threaded)) {
+        controller.setThreaded(threaded);
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Pokolenia liczone bez limitu klatek; wyłączone = pokolenia w wątku okna, w budżecie klatki");
+
+    // Turbo w trybie inline: tyle pokoleń na klatkę, ile mieści się w budżecie czasu
+    if (!threaded) {
+        float budgetMs = (float)controller.frameBudget();
+        if (ImGui::SliderFloat("Budżet klatki (ms)", &budgetMs, 0.0f, 50.0f, "%.1f")) {
+            controller.setFrameBudget(budgetMs);
+        }
+        if (ImGui::IsItemHovered()) ImGui::SetTooltip("0 = jedno pokolenie na klatkę; więcej = turbo (okno nadal odświeża się raz na klatkę)");
+        ImGui::SameLine();
+        ImGui::TextDisabled("%d/klatkę", snap.generationsPerFrame);
+    }
+
+    bool drawGrid = controller.captureGrid();
+    if (ImGui::Checkbox("Rysuj planszę", &drawGrid)) {
+        controller.setCaptureGrid(drawGrid);
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Wyłączone: tylko metryki i wykresy, bez kopiowania i rysowania siatki");
 
     ImGui::Separator();
 
@@ -70,19 +113,23 @@ void GuiPanel::update(sf::RenderWindow& win, LeftPanelMode& leftMode) {
         ImGui::TextDisabled("Wybierz aktywne strategie:");
 
         // Kolorowe checkbox'y
-        ImGui::Checkbox("Zieloni (Always C)", &sim.useAlwaysCooperate);
-        ImGui::Checkbox("Czerwoni (Always D)", &sim.useAlwaysDefect);
-        ImGui::Checkbox("Niebiescy (Tit-For-Tat)", &sim.useTitForTat);
-        ImGui::Checkbox("Żółci (Pavlov)", &sim.usePavlov);
-        ImGui::Checkbox("Fioletowi (Dyskryminator)", &sim.useDiscriminator);
+        ImGui::Checkbox("Zieloni (Always C)", &params.useAlwaysCooperate);
+        ImGui::Checkbox("Czerwoni (Always D)", &params.useAlwaysDefect);
+        ImGui::Checkbox("Niebiescy (Tit-For-Tat)", &params.useTitForTat);
+        ImGui::Checkbox("Żółci (Pavlov)", &params.usePavlov);
+        ImGui::Checkbox("Fioletowi (Dyskryminator)", &params.useDiscriminator);
 
         ImGui::Dummy(ImVec2(0.0f, 5.0f));
 
-        ImGui::SliderFloat("Gęstość (Density)", &sim.density, 0.01f, 1.0f);
+        ImGui::SliderFloat("Gęstość (Density)", &params.density, 0.01f, 1.0f);
         if (ImGui::IsItemHovered()) ImGui::SetTooltip("Ile planszy jest zajęte na starcie");
 
+        ImGui::InputScalar("Ziarno (Seed)", ImGuiDataType_U64, &params.seed);
+        if (ImGui::IsItemHovered()) ImGui::SetTooltip("Ten sam seed = ten sam przebieg (niezależnie od liczby wątków)");
+
         if (ImGui::Button("Zastosuj i Resetuj", ImVec2(availWidth, 0.0f))) {
-            sim.reset();
+            sendParams();
+            controller.post([](Simulation& sim) { sim.reset(); });
         }
     }
 
@@ -104,22 +151,22 @@ void GuiPanel::update(sf::RenderWindow& win, LeftPanelMode& leftMode) {
             case 1: // Dylemat Więźnia: T > R > P > S
                 // Pokusa zdrady (5) jest silna, ale współpraca (3) lepsza niż obustronna zdrada (1).
                 // Efekt: Powstawanie klastrów obronnych.
-                sim.matrix = { 3.0f, 5.0f, 0.0f, 1.0f };
+                params.matrix = { 3.0f, 5.0f, 0.0f, 1.0f };
                 break;
             case 2: // Polowanie na Jelenia: R > T >= P > S
                 // Współpraca (5) jest najbardziej opłacalna, ale wymaga zaufania.
                 // Zdrada (3) jest bezpieczniejsza ("polowanie na zająca").
                 // Efekt: Dwa stabilne stany - albo wszyscy współpracują, albo wszyscy zdradzają.
-                sim.matrix = { 5.0f, 3.0f, 0.0f, 1.0f };
+                params.matrix = { 5.0f, 3.0f, 0.0f, 1.0f };
                 break;
             case 3: // Jastrząb-Gołąb (Tchórz): T > R > S > P
                 // Najgorsza jest walka (P=0). Lepiej ustąpić i być "frajerem" (S=1) niż zginąć.
                 // Efekt: Szachownica/Wymieszanie. Jastrzębie żyją obok Gołębi.
-                sim.matrix = { 3.0f, 5.0f, 1.0f, 0.0f };
+                params.matrix = { 3.0f, 5.0f, 1.0f, 0.0f };
                 break;
             case 4: // Harmonia: R > T > S > P
                 // Współpraca zawsze się opłaca.
-                sim.matrix = { 5.0f, 4.0f, 1.0f, 0.0f };
+                params.matrix = { 5.0f, 4.0f, 1.0f, 0.0f };
                 break;
             }
         }
@@ -127,20 +174,20 @@ void GuiPanel::update(sf::RenderWindow& win, LeftPanelMode& leftMode) {
         ImGui::Dummy(ImVec2(0.0f, 5.0f)); // Odstęp
         ImGui::TextDisabled("Ręczna edycja parametrów:");
 
-        ImGui::SliderFloat("Nagroda (R)", &sim.matrix.R, 0.0f, 6.0f);
+        ImGui::SliderFloat("Nagroda (R)", &params.matrix.R, 0.0f, 6.0f);
         if (ImGui::IsItemHovered()) ImGui::SetTooltip("Reward: Zysk za obustronną współpracę");
 
-        ImGui::SliderFloat("Pokusa (T)", &sim.matrix.T, 0.0f, 6.0f);
+        ImGui::SliderFloat("Pokusa (T)", &params.matrix.T, 0.0f, 6.0f);
         if (ImGui::IsItemHovered()) ImGui::SetTooltip("Temptation: Zysk za zdradę naiwnego");
 
-        ImGui::SliderFloat("Jeleń (S)", &sim.matrix.S, 0.0f, 6.0f);
+        ImGui::SliderFloat("Jeleń (S)", &params.matrix.S, 0.0f, 6.0f);
         if (ImGui::IsItemHovered()) ImGui::SetTooltip("Sucker: Wypłata gdy współpracujesz a ciebie zdradzają");
 
-        ImGui::SliderFloat("Kara (P)", &sim.matrix.P, 0.0f, 6.0f);
+        ImGui::SliderFloat("Kara (P)", &params.matrix.P, 0.0f, 6.0f);
         if (ImGui::IsItemHovered()) ImGui::SetTooltip("Punishment: Kara za obustronną zdradę");
 
         ImGui::Separator();
-        ImGui::Checkbox("Normalizuj Wypłaty", &sim.normalizePayoff);
+        ImGui::Checkbox("Normalizuj Wypłaty", &params.normalizePayoff);
         if (ImGui::IsItemHovered()) ImGui::SetTooltip("Dzieli wynik przez liczbę sąsiadów (ważne przy pustych polach)");
     }
 
@@ -148,15 +195,15 @@ void GuiPanel::update(sf::RenderWindow& win, LeftPanelMode& leftMode) {
     if (ImGui::CollapsingHeader("Środowisko (Grid)")) {
 
         const char* boundaryItems[] = { "Periodic (Zawijanie)", "Ściana (Fixed)", "Odbicie (Reflective)", "Pustka (Absorbing)" };
-        int boundaryIdx = static_cast<int>(sim.grid.boundary);
+        int boundaryIdx = static_cast<int>(params.boundary);
         if (ImGui::Combo("Granice", &boundaryIdx, boundaryItems, IM_ARRAYSIZE(boundaryItems))) {
-            sim.grid.boundary = static_cast<BoundaryMode>(boundaryIdx);
+            params.boundary = static_cast<BoundaryMode>(boundaryIdx);
         }
 
         const char* neighborhoodItems[] = { "Moore (8 sąsiadów)", "von Neumann (4 sąsiadów)" };
-        int neighIdx = static_cast<int>(sim.grid.neighborhood);
+        int neighIdx = static_cast<int>(params.neighborhood);
         if (ImGui::Combo("Sąsiedztwo", &neighIdx, neighborhoodItems, IM_ARRAYSIZE(neighborhoodItems))) {
-            sim.grid.neighborhood = static_cast<NeighborhoodType>(neighIdx);
+            params.neighborhood = static_cast<NeighborhoodType>(neighIdx);
         }
     }
 
@@ -164,59 +211,91 @@ void GuiPanel::update(sf::RenderWindow& win, LeftPanelMode& leftMode) {
     if (ImGui::CollapsingHeader("Parametry Ewolucji")) {
 
         const char* modes[] = { "Imitacja (Strategiczna)", "Death-Birth (Biologiczna)" };
-        int modeIdx = (sim.mode == EvolutionMode::Imitation) ? 0 : 1;
+        int modeIdx = (params.mode == EvolutionMode::Imitation) ? 0 : 1;
         if (ImGui::Combo("Tryb Ewolucji", &modeIdx, modes, IM_ARRAYSIZE(modes))) {
-            sim.mode = (modeIdx == 0) ? EvolutionMode::Imitation : EvolutionMode::DeathBirth;
+            params.mode = (modeIdx == 0) ? EvolutionMode::Imitation : EvolutionMode::DeathBirth;
         }
 
         ImGui::TextDisabled("--- Imitation Mode ---");
 
         const char* rules[] = { "Najlepszy Sąsiad", "Fermi (Probabilistyczne)" };
-        int ruleIdx = (sim.updateRule == UpdateRule::BestNeighbor) ? 0 : 1;
+        int ruleIdx = (params.updateRule == UpdateRule::BestNeighbor) ? 0 : 1;
         if (ImGui::Combo("Reguła Zmian", &ruleIdx, rules, IM_ARRAYSIZE(rules))) {
-            sim.updateRule = (ruleIdx == 0) ? UpdateRule::BestNeighbor : UpdateRule::Fermi;
+            params.updateRule = (ruleIdx == 0) ? UpdateRule::BestNeighbor : UpdateRule::Fermi;
         }
 
-        if (sim.updateRule == UpdateRule::Fermi) {
-            ImGui::SliderFloat("Szum Fermi (K)", &sim.fermiK, 0.01f, 2.0f, "%.3f");
+        if (params.updateRule == UpdateRule::Fermi) {
+            ImGui::SliderFloat("Szum Fermi (K)", &params.fermiK, 0.01f, 2.0f, "%.3f");
             if (ImGui::IsItemHovered()) ImGui::SetTooltip("Im wyższe K, tym więcej losowości i błędów w decyzjach");
         }
 
-        ImGui::SliderFloat("Mutacja", &sim.mutationRate, 0.0f, 0.05f, "%.4f");
+        ImGui::SliderFloat("Mutacja", &params.mutationRate, 0.0f, 0.05f, "%.4f");
 
         ImGui::TextDisabled("--- Death-Birth Mode ---");
-        ImGui::SliderFloat("Tempo Rozrodu", &sim.reproductionProb, 0.0f, 1.0f, "%.2f");
+        ImGui::SliderFloat("Tempo Rozrodu", &params.reproductionProb, 0.0f, 1.0f, "%.2f");
         if (ImGui::IsItemHovered()) ImGui::SetTooltip("Szansa na zajęcie pustego pola (niższa = więcej wolnego miejsca)");
 
-        ImGui::SliderFloat("Śmiertelność", &sim.deathProb, 0.0f, 0.2f, "%.3f");
-        ImGui::SliderFloat("Siła Selekcji (Beta)", &sim.selectionBeta, 0.0f, 5.0f, "%.2f");
+        ImGui::SliderFloat("Śmiertelność", &params.deathProb, 0.0f, 0.2f, "%.3f");
+        ImGui::SliderFloat("Siła Selekcji (Beta)", &params.selectionBeta, 0.0f, 5.0f, "%.2f");
         if (ImGui::IsItemHovered()) ImGui::SetTooltip("Jak bardzo zysk wpływa na szansę rozmnożenia");
+
+        const char* schedulings[] = { "Szeregowo (Raster)", "Równolegle (Klasy Kolorów)" };
+        int schedIdx = static_cast<int>(params.birthScheduling);
+        if (ImGui::Combo("Kolejność Narodzin", &schedIdx, schedulings, IM_ARRAYSIZE(schedulings))) {
+            params.birthScheduling = static_cast<UpdateScheduling>(schedIdx);
+        }
+        if (ImGui::IsItemHovered()) ImGui::SetTooltip("Równolegle: sąsiednie pola nigdy nie rodzą w tej samej fazie (wynik powtarzalny, inny niż szeregowy)");
     }
 
     // --- SEKCJA 5: RUCH ---
     if (ImGui::CollapsingHeader("Migracja (Ruch)")) {
-        ImGui::SliderFloat("Szansa Ruchu", &sim.moveProb, 0.0f, 1.0f, "%.2f");
-        ImGui::SliderFloat("Próg Ruchu (Eps)", &sim.moveEpsilon, 0.0f, 1.0f, "%.3f");
+        ImGui::SliderFloat("Szansa Ruchu", &params.moveProb, 0.0f, 1.0f, "%.2f");
+        ImGui::SliderFloat("Próg Ruchu (Eps)", &params.moveEpsilon, 0.0f, 1.0f, "%.3f");
         if (ImGui::IsItemHovered()) ImGui::SetTooltip("Minimalny wzrost zysku wymagany do przeprowadzki");
+
+        const char* moveSchedulings[] = { "Szeregowo (Losowa Kolejność)", "Równolegle (Propozycje)" };
+        int moveSchedIdx = static_cast<int>(params.migrationScheduling);
+        if (ImGui::Combo("Kolejność Ruchu", &moveSchedIdx, moveSchedulings, IM_ARRAYSIZE(moveSchedulings))) {
+            params.migrationScheduling = static_cast<UpdateScheduling>(moveSchedIdx);
+        }
+        if (ImGui::IsItemHovered()) ImGui::SetTooltip("Równolegle: wszyscy wybierają cel na tym samym stanie, spór o pole wygrywa losowy priorytet");
     }
 
     // --- SEKCJA 6: REPUTACJA I PAMIĘĆ ---
     if (ImGui::CollapsingHeader("Gra Iterowana & Reputacja")) {
 
-        ImGui::SliderInt("Rundy na pokolenie", &sim.roundsPerGeneration, 1, 200);
+        ImGui::SliderInt("Rundy na pokolenie", &params.roundsPerGeneration, 1, 200);
         if (ImGui::IsItemHovered()) ImGui::SetTooltip("Ile razy agenci grają ze sobą zanim nastąpi śmierć/rozród");
 
         ImGui::Separator();
         ImGui::TextDisabled("Parametry Dyskryminatora:");
 
-        ImGui::SliderFloat("Pamięć Reputacji (Alpha)", &sim.reputationAlpha, 0.0f, 0.5f, "%.3f");
+        ImGui::SliderFloat("Pamięć Reputacji (Alpha)", &params.reputationAlpha, 0.0f, 0.5f, "%.3f");
         if (ImGui::IsItemHovered()) ImGui::SetTooltip("Jak szybko zmienia się opinia o agencie (0.1 = wolno, 0.5 = szybko)");
 
-        ImGui::SliderFloat("Próg Zaufania", &sim.reputationThreshold, 0.0f, 1.0f, "%.2f");
+        ImGui::SliderFloat("Próg Zaufania", &params.reputationThreshold, 0.0f, 1.0f, "%.2f");
         if (ImGui::IsItemHovered()) ImGui::SetTooltip("Minimalna reputacja sąsiadów, by Dyskryminator współpracował");
 
         // Podgląd na żywo
-        ImGui::Text("Średnia reputacja populacji: %.3f", sim.lastMetrics.avgReputation);
+        ImGui::Text("Średnia reputacja populacji: %.3f", snap.lastMetrics.avgReputation);
+    }
+
+    // --- SEKCJA 6b: PROFIL CZASOWY ---
+    if (PhaseTimers::enabled && ImGui::CollapsingHeader("Czasy Faz (Profil)")) {
+        const PhaseTimes& t = snap.times;
+        const double total = t.totalMs > 0.0 ? t.totalMs : 1.0;
+
+        ImGui::Text("Pokolenie: %.2f ms", t.totalMs);
+
+        for (size_t p = 0; p < PHASE_COUNT; ++p) {
+            const Phase phase = (Phase)p;
+            const bool subPhase = (phase == Phase::RoundDecide || phase == Phase::RoundPayoff || phase == Phase::RoundApply);
+
+            char overlay[64];
+            std::snprintf(overlay, sizeof(overlay), "%s%s: %.2f ms", subPhase ? "  " : "", phaseName(phase), t[phase]);
+            ImGui::ProgressBar((float)(t[phase] / total), ImVec2(-1.0f, 0.0f), overlay);
+        }
+        if (ImGui::IsItemHovered()) ImGui::SetTooltip("Round* to sekcje OpenMP jednej rundy, zsumowane po K rundach (część Rounds)");
     }
 
     ImGui::Separator();
@@ -231,19 +310,86 @@ void GuiPanel::update(sf::RenderWindow& win, LeftPanelMode& leftMode) {
     ImGui::Dummy(ImVec2(0.0f, 10.0f)); // Odstęp
     ImGui::SeparatorText("Eksport Danych (CSV)");
 
-    if (ImGui::Checkbox("Nagrywaj (REC)", &sim.exportCsvEnabled)) {
-        // Logika on/off
+    if (ImGui::Checkbox("Nagrywaj (REC)", &params.exportCsvEnabled)) {
+        // Wiersze czekające w buforze trafiają do pliku od razu, a nie przy następnym kroku
+        sendParams();
+        controller.post([](Simulation& sim) { sim.flushCsvFile(); });
     }
     ImGui::SameLine();
 
     ImGui::TextDisabled("(%s)", "metrics.csv");
 
+    if (PhaseTimers::enabled) {
+        ImGui::Checkbox("Kolumny czasów faz", &params.exportTimings);
+        if (ImGui::IsItemHovered()) ImGui::SetTooltip("Dodaje kolumny Time_* (ms) - działa od nowego pliku");
+    }
+
     if (ImGui::Button("Wyczyść / Nowy Plik", ImVec2(availWidth, 0.0f))) {
-        sim.newCsvFile();
+        sendParams();
+        controller.post([](Simulation& sim) { sim.newCsvFile(); });
     }
     if (ImGui::IsItemHovered()) {
         ImGui::SetTooltip("Usuwa zawartość pliku i zaczyna zapis od nowa");
     }
 
+    ImGui::SeparatorText("Punkt Kontrolny");
+
+    // Pełny stan (populacja, pamięć, parametry, pokolenie, seed) w checkpoint.sevo.
+    // Zapis i odczyt czekają na koniec bieżącego pokolenia (exclusive).
+    if (ImGui::Button("Zapisz stan", ImVec2(availWidth * 0.5f - 4.f, 0.0f))) {
+        sendParams();
+        controller.exclusive([&](Simulation& sim) {
+            std::string error;
+            checkpointStatus = Checkpoint::save(sim, Checkpoint::DEFAULT_PATH, error)
+                ? "Zapisano pokolenie " + std::to_string(sim.generation)
+                : "Błąd: " + error;
+        });
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Wczytaj stan", ImVec2(availWidth * 0.5f - 4.f, 0.0f))) {
+        sendParams();
+        controller.exclusive([&](Simulation& sim) {
+            std::string error;
+            checkpointStatus = Checkpoint::load(sim, Checkpoint::DEFAULT_PATH, error)
+                ? "Wczytano pokolenie " + std::to_string(sim.generation)
+                : "Błąd: " + error;
+            params = sentParams = SimulationParams::capture(sim); // suwaki pokazują wczytane wartości
+        });
+    }
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Przywraca populację, pamięć relacji, parametry i historię wykresów");
+    if (!checkpointStatus.empty()) ImGui::TextDisabled("%s (%s)", checkpointStatus.c_str(), Checkpoint::DEFAULT_PATH);
+
+    ImGui::SeparatorText("Ślad Wykonania (Perfetto)");
+
+    // Start jako polecenie: wykonuje go wątek silnika między pokoleniami, więc to on rejestruje
+    // swój bufor (a nie pierwsze step()). Zapis w exclusive(), gdy żaden wątek symulacji nie pracuje.
+    if (!Trace::active()) {
+        if (ImGui::Button("Nagraj ślad", ImVec2(availWidth, 0.0f))) {
+            controller.post([](Simulation&) { Trace::start(); });
+            traceStatus.clear();
+        }
+        if (ImGui::IsItemHovered()) ImGui::SetTooltip("Zdarzenia faz i wątków OpenMP do pliku trace.json");
+    }
+    else {
+        if (ImGui::Button("Zatrzymaj i zapisz (trace.json)", ImVec2(availWidth, 0.0f))) {
+            controller.exclusive([&](Simulation&) {
+                Trace::stop();
+                std::string error;
+                if (Trace::writeChromeJson("trace.json", error)) {
+                    traceStatus = "Zapisano " + std::to_string(Trace::eventCount()) + " zdarzeń";
+                    if (Trace::droppedCount() > 0) traceStatus += ", odrzucono " + std::to_string(Trace::droppedCount());
+                }
+                else {
+                    traceStatus = "Błąd: " + error;
+                }
+            });
+        }
+        ImGui::TextDisabled("Nagrywanie: %zu zdarzeń", Trace::eventCount());
+    }
+    if (!traceStatus.empty()) ImGui::TextDisabled("%s", traceStatus.c_str());
+
     ImGui::End();
+
+    // Zmiany suwaków z tej klatki trafiają do silnika jednym poleceniem
+    sendParams();
 }
\ No newline at end of file
@@ -1,25 +1,26 @@
 #include "LeftPanel.hpp"
-#include "Agent.hpp" // Potrzebne do kolorów i typów
+#include "Agent.hpp" // Potrzebne do typów
 #include <cfloat>
 #include <vector>
 #include <algorithm>
+#include <cmath>
 #include <cstdio> // do sprintf
 
 // Makro dla wygody (opcjonalne)
 #define PL(s) s 
 
-LeftPanel::LeftPanel(Simulation& s, SimulationRenderer& r)
-    : sim(s), renderer(r) {
+LeftPanel::LeftPanel(SimulationRenderer& r)
+    : renderer(r) {
 }
 
 void LeftPanel::setSize(sf::Vector2u size) {
-    mapTexture.resize(size);
+    viewSize = { (float)size.x, (float)size.y };
 }
 
 void LeftPanel::setMode(LeftPanelMode m) { mode = m; }
 LeftPanelMode LeftPanel::getMode() const { return mode; }
 
-void LeftPanel::draw() {
+void LeftPanel::draw(const SimulationSnapshot& snap) {
     // Ustawiamy pozycję i rozmiar okna
     ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_Always);
     ImGui::SetNextWindowSize(ImVec2((float)LEFT_PANEL_WIDTH, (float)WINDOW_HEIGHT), ImGuiCond_Always);
@@ -28,17 +29,22 @@ void LeftPanel::draw() {
 
     ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, padding);
 
+    // Obraz planszy może wystawać poza panel (przycięty), więc w widoku symulacji bez przewijania
+    const int scrollFlags = (mode == LeftPanelMode::Simulation)
+        ? (ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse) : 0;
+
     ImGui::Begin("LeftPanel", nullptr,
         ImGuiWindowFlags_NoResize |
         ImGuiWindowFlags_NoMove |
         ImGuiWindowFlags_NoCollapse |
-        ImGuiWindowFlags_NoTitleBar);
+        ImGuiWindowFlags_NoTitleBar |
+        scrollFlags);
 
     if (mode == LeftPanelMode::Simulation) {
-        drawSimulationView();
+        drawSimulationView(snap);
     }
     else {
-        drawMetricsView();
+        drawMetricsView(snap);
     }
 
     ImGui::End();
@@ -46,17 +52,97 @@ void LeftPanel::draw() {
     ImGui::PopStyleVar(); // Zdejmujemy styl paddingu
 }
 
-void LeftPanel::drawSimulationView() {
-    mapTexture.clear(sf::Color::Black);
-    renderer.draw(mapTexture);
-    mapTexture.display();
+void LeftPanel::handleViewInput(const SimulationSnapshot& snap, ImVec2 origin) {
+    const ImGuiIO& io = ImGui::GetIO();
+    const GridView fitted = GridView::fit(snap.width, snap.height, viewSize);
+
+    if (ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+        fitView = true;
+        return;
+    }
+
+    // Przybliżenie wokół kursora: komórka pod kursorem zostaje na miejscu
+    if (ImGui::IsItemHovered() && io.MouseWheel != 0.0f) {
+        const float scale = std::clamp(view.scale * std::pow(1.25f, io.MouseWheel), fitted.scale * 0.5f, 64.0f);
+        const float mx = io.MousePos.x - origin.x;
+        const float my = io.MousePos.y - origin.y;
+        view.originX += mx / view.scale - mx / scale;
+        view.originY += my / view.scale - my / scale;
+        view.scale = scale;
+        fitView = false;
+    }
+
+    if (ImGui::IsItemActive() && ImGui::IsMouseDragging(ImGuiMouseButton_Left, 0.0f)) {
+        view.originX -= io.MouseDelta.x / view.scale;
+        view.originY -= io.MouseDelta.y / view.scale;
+        fitView = false;
+    }
+
+    // Środek widoku zostaje nad planszą, żeby nie zgubić jej przy przesuwaniu
+    const float halfW = viewSize.x / (2.0f * view.scale);
+    const float halfH = viewSize.y / (2.0f * view.scale);
+    view.originX = std::clamp(view.originX, -halfW, snap.width - halfW);
+    view.originY = std::clamp(view.originY, -halfH, snap.height - halfH);
+}
+
+void LeftPanel::drawSimulationView(const SimulationSnapshot& snap) {
+    const ImVec2 origin = ImGui::GetCursorScreenPos();
+
+    // Nowy rozmiar siatki (np. wczytany punkt kontrolny): wracamy do całej planszy
+    if (snap.width != viewGridWidth || snap.height != viewGridHeight) {
+        viewGridWidth = snap.width;
+        viewGridHeight = snap.height;
+        fitView = true;
+    }
+
+    // Cały panel przyjmuje mysz; nakładki rysowane później też mogą być klikane
+    ImGui::SetNextItemAllowOverlap();
+    ImGui::InvisibleButton("##grid", ImVec2(viewSize.x, viewSize.y));
+    if (fitView) view = GridView::fit(snap.width, snap.height, viewSize);
+    handleViewInput(snap, origin);
+
+    // Bez rysowania planszy zostaje ostatni obraz; metryki w prawym panelu i tak się odświeżają
+    if (snap.hasGrid) {
+        renderer.update(snap, view, viewSize); // tylko widoczny wycinek
+    }
+
+    if (renderer.hasImage()) {
+        const sf::Vector2f pos = renderer.imagePosition();
+        const sf::Vector2f size = renderer.imageSize();
+        ImGui::SetCursorScreenPos(ImVec2(origin.x + pos.x, origin.y + pos.y));
+        ImGui::Image(sf::Sprite(renderer.texture(), renderer.imageRect()), size);
+    }
 
-    ImGui::Image(mapTexture.getTexture());
+    // Nakładka: stan rysowania i skala
+    char buf[96];
+    if (!snap.hasGrid) {
+        std::snprintf(buf, sizeof(buf), "Rysowanie planszy wyłączone (pokolenie %d)", snap.generation);
+    }
+    else if (renderer.level() > 0) {
+        const int unit = 1 << renderer.level();
+        std::snprintf(buf, sizeof(buf), "Piksel = kafelek %dx%d komórek (2x klik: cała plansza)", unit, unit);
+    }
+    else {
+        std::snprintf(buf, sizeof(buf), "%.1f px/komórkę", view.scale);
+    }
+    ImGui::GetWindowDrawList()->AddText(ImVec2(origin.x + 6.0f, origin.y + 4.0f), IM_COL32(220, 220, 220, 255), buf);
+
+    // Kolorowanie kafelków ma sens tylko po oddaleniu
+    if (renderer.level() > 0) {
+        ImGui::SetCursorScreenPos(ImVec2(origin.x + 6.0f, origin.y + 24.0f));
+        if (ImGui::RadioButton("Typ", renderer.getShading() == TileShading::MajorityType)) {
+            renderer.setShading(TileShading::MajorityType);
+        }
+        ImGui::SameLine();
+        if (ImGui::RadioButton("Kooperacja", renderer.getShading() == TileShading::Cooperation)) {
+            renderer.setShading(TileShading::Cooperation);
+        }
+    }
 }
 
 // Szablon pomocniczy do wykresów
 template <typename T>
-static void fillSeriesWindowed(const std::deque<MetricsSample>& hist,
+static void fillSeriesWindowed(const RingBuffer<MetricsSample>& hist,
     int window,
     std::vector<float>& out,
     T MetricsSample::* field)
@@ -80,8 +166,8 @@ static void DrawColoredProgressBar(float fraction, const ImVec4& color, const ch
     ImGui::PopStyleColor();
 }
 
-void LeftPanel::drawMetricsView() {
-    const auto& m = sim.lastMetrics;
+void LeftPanel::drawMetricsView(const SimulationSnapshot& snap) {
+    const auto& m = snap.lastMetrics;
     float totalPop = (float)std::max(1, m.alive);
 
     // --- NAGŁÓWEK ---
@@ -93,7 +179,7 @@ void LeftPanel::drawMetricsView() {
     ImGui::Text("Gen: %d", m.generation);
     ImGui::SetWindowFontScale(1.0f);
 
-    ImGui::Text("Populacja: %d / %d", m.alive, sim.grid.width * sim.grid.height);
+    ImGui::Text("Populacja: %d / %d", m.alive, snap.width * snap.height);
 
     // 1. Wskaźnik KOOPERACJI (Zachowanie)
     float coopP = m.coopRatio;
@@ -198,15 +284,15 @@ void LeftPanel::drawMetricsView() {
     static std::vector<float> popC, popD, popTFT, popPavlov, popDisc;
     static std::vector<float> histRep; // Dane dla reputacji
 
-    fillSeriesWindowed(sim.history, plotWindow, popC, &MetricsSample::countAlwaysC);
-    fillSeriesWindowed(sim.history, plotWindow, popD, &MetricsSample::countAlwaysD);
-    fillSeriesWindowed(sim.history, plotWindow, popTFT, &MetricsSample::countTitForTat);
-    fillSeriesWindowed(sim.history, plotWindow, popPavlov, &MetricsSample::countPavlov);
-    fillSeriesWindowed(sim.history, plotWindow, popDisc, &MetricsSample::countDiscriminator);
+    fillSeriesWindowed(snap.history, plotWindow, popC, &MetricsSample::countAlwaysC);
+    fillSeriesWindowed(snap.history, plotWindow, popD, &MetricsSample::countAlwaysD);
+    fillSeriesWindowed(snap.history, plotWindow, popTFT, &MetricsSample::countTitForTat);
+    fillSeriesWindowed(snap.history, plotWindow, popPavlov, &MetricsSample::countPavlov);
+    fillSeriesWindowed(snap.history, plotWindow, popDisc, &MetricsSample::countDiscriminator);
     // Pobieramy historię reputacji
-    fillSeriesWindowed(sim.history, plotWindow, histRep, &MetricsSample::avgReputation);
+    fillSeriesWindowed(snap.history, plotWindow, histRep, &MetricsSample::avgReputation);
 
-    float maxPop = (float)(sim.grid.width * sim.grid.height);
+    float maxPop = (float)(snap.width * snap.height);
     ImVec2 plotSize(ImGui::GetContentRegionAvail().x, 50.0f);
 
     ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0, 2)); // Mniejszy odstęp między wykresami
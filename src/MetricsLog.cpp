@@ -0,0 +1,467 @@
+#include "MetricsLog.hpp"
+#include "Simulation.hpp"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+
+    constexpr char MAGIC[8] = { 'S', 'E', 'V', 'O', 'M', 'L', 'O', 'G' };
+    constexpr uint32_t BLOCK_MAGIC = 0x4B4C424Du; // "MBLK"
+    constexpr size_t BLOCK_HEADER_BYTES = 24;
+
+    enum Encoding : uint8_t {
+        RAW = 0,   // wartości kolumny jedna po drugiej (4 albo 8 bajtów)
+        PACKED = 1 // różnice / XOR + varint
+    };
+
+    // Liczby w pliku zawsze little-endian, niezależnie od maszyny
+    void putU32(std::string& out, uint32_t v) {
+        for (int i = 0; i < 4; ++i) out.push_back((char)((v >> (8 * i)) & 0xFF));
+    }
+
+    uint32_t getU32(const uint8_t* p) {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    void putVarint(std::string& out, uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back((char)(uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((char)(uint8_t)v);
+    }
+
+    bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64 && p < end; shift += 7) {
+            const uint8_t b = *p++;
+            v |= (uint64_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+    int64_t unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+    size_t valueBytes(MetricsLog::ColumnType type) {
+        return type == MetricsLog::ColumnType::Float64 ? 8 : 4;
+    }
+}
+
+uint64_t MetricsLog::bitsOf(float v) {
+    return std::bit_cast<uint32_t>(v);
+}
+
+uint64_t MetricsLog::bitsOf(double v) {
+    return std::bit_cast<uint64_t>(v);
+}
+
+std::vector<MetricsLog::Column> MetricsLog::metricsColumns(bool timingColumns) {
+    using T = ColumnType;
+    std::vector<Column> cols = {
+        { "Generation", T::Int32 }, { "Alive", T::Int32 }, { "Empty", T::Int32 }, { "Coop", T::Int32 }, { "Defect", T::Int32 },
+        { "CoopRatio", T::Float32 }, { "AvgReputation", T::Float32 }, { "AvgStrategyAge", T::Float32 },
+        { "Count_AC", T::Int32 }, { "Count_AD", T::Int32 }, { "Count_TFT", T::Int32 }, { "Count_Pavlov", T::Int32 }, { "Count_Disc", T::Int32 },
+        { "Payoff_AC", T::Float32 }, { "Payoff_AD", T::Float32 }, { "Payoff_TFT", T::Float32 }, { "Payoff_Pavlov", T::Float32 }, { "Payoff_Disc", T::Float32 },
+        { "Rep_AC", T::Float32 }, { "Rep_AD", T::Float32 }, { "Rep_TFT", T::Float32 }, { "Rep_Pavlov", T::Float32 }, { "Rep_Disc", T::Float32 }
+    };
+
+    if (timingColumns) {
+        for (size_t p = 0; p < PHASE_COUNT; ++p) {
+            // Jak w CSV: eksport bieżącego pokolenia jeszcze trwa, więc kolumna dotyczy poprzedniego
+            std::string name = std::string("Time_") + phaseName((Phase)p) + ((Phase)p == Phase::Export ? "Prev" : "");
+            cols.push_back({ name, T::Float64 });
+        }
+    }
+    return cols;
+}
+
+void MetricsLog::metricsRow(const MetricsSample& m, uint64_t* out) {
+    const uint64_t row[] = {
+        bitsOf(m.generation), bitsOf(m.alive), bitsOf(m.empty), bitsOf(m.coop), bitsOf(m.defect),
+        bitsOf(m.coopRatio), bitsOf(m.avgReputation), bitsOf(m.avgStrategyAge),
+        bitsOf(m.countAlwaysC), bitsOf(m.countAlwaysD), bitsOf(m.countTitForTat), bitsOf(m.countPavlov), bitsOf(m.countDiscriminator),
+        bitsOf(m.avgPayoffAlwaysC), bitsOf(m.avgPayoffAlwaysD), bitsOf(m.avgPayoffTFT), bitsOf(m.avgPayoffPavlov), bitsOf(m.avgPayoffDiscriminator),
+        bitsOf(m.avgRepAlwaysC), bitsOf(m.avgRepAlwaysD), bitsOf(m.avgRepTFT), bitsOf(m.avgRepPavlov), bitsOf(m.avgRepDiscriminator)
+    };
+    static_assert(sizeof(row) / sizeof(row[0]) == METRICS_COLUMNS, "kolumny jak w metricsColumns");
+    std::memcpy(out, row, sizeof(row));
+}
+
+// =========================
+// Encoder
+// =========================
+
+void MetricsLog::Encoder::begin(const Header& header, int rowsPerBlock) {
+    schema = header;
+    blockRows = rowsPerBlock > 0 ? rowsPerBlock : 1;
+    rows = 0;
+    columns.assign(schema.columns.size(), std::vector<uint64_t>((size_t)blockRows));
+}
+
+void MetricsLog::Encoder::writeHeader(std::string& out) const {
+    std::string params;
+    for (const auto& [key, value] : schema.params) {
+        params += key + "=" + value + "\n";
+    }
+
+    out.append(MAGIC, sizeof(MAGIC));
+    putU32(out, VERSION);
+    putU32(out, schema.compressed ? 1u : 0u);
+    putU32(out, (uint32_t)schema.columns.size());
+    putU32(out, (uint32_t)params.size());
+
+    for (const Column& c : schema.columns) {
+        out.push_back((char)c.type);
+        out.push_back((char)(uint8_t)c.name.size());
+        out += c.name;
+    }
+    out += params;
+}
+
+void MetricsLog::Encoder::push(const uint64_t* values) {
+    if (rows == 0) firstRowTime = std::chrono::steady_clock::now();
+    for (size_t c = 0; c < columns.size(); ++c) {
+        columns[c][(size_t)rows] = values[c];
+    }
+    rows++;
+}
+
+std::chrono::steady_clock::duration MetricsLog::Encoder::pendingAge() const {
+    return rows ? std::chrono::steady_clock::now() - firstRowTime : std::chrono::steady_clock::duration::zero();
+}
+
+void MetricsLog::Encoder::encodeBlock(std::string& out) {
+    if (rows == 0) return;
+
+    const size_t headerAt = out.size();
+    out.append(BLOCK_HEADER_BYTES, '\0');
+    const size_t payloadAt = out.size();
+
+    for (size_t c = 0; c < columns.size(); ++c) {
+        const ColumnType type = schema.columns[c].type;
+        const uint64_t* v = columns[c].data();
+
+        if (!schema.compressed) {
+            for (int i = 0; i < rows; ++i) {
+                uint64_t x = v[i];
+                for (size_t b = 0; b < valueBytes(type); ++b) out.push_back((char)((x >> (8 * b)) & 0xFF));
+            }
+            continue;
+        }
+
+        // Blok zaczyna od zera, więc każdy blok dekoduje się samodzielnie
+        uint64_t prev = 0;
+        for (int i = 0; i < rows; ++i) {
+            if (type == ColumnType::Int32) {
+                putVarint(out, zigzag((int64_t)(int32_t)(uint32_t)v[i] - (int64_t)(int32_t)(uint32_t)prev));
+            }
+            else {
+                putVarint(out, v[i] ^ prev);
+            }
+            prev = v[i];
+        }
+    }
+
+    std::string header;
+    putU32(header, BLOCK_MAGIC);
+    putU32(header, (uint32_t)rows);
+    putU32(header, (uint32_t)columns[0][0]);
+    putU32(header, (uint32_t)columns[0][(size_t)rows - 1]);
+    putU32(header, (uint32_t)(out.size() - payloadAt));
+    header.push_back((char)(schema.compressed ? PACKED : RAW));
+    header.append(3, '\0');
+    out.replace(headerAt, BLOCK_HEADER_BYTES, header);
+
+    rows = 0;
+}
+
+// =========================
+// Reader
+// =========================
+
+bool MetricsLog::Reader::open(const std::string& path, std::string& error) {
+    in.open(path, std::ios::binary);
+    filePath = path;
+    segmentIndex = 0;
+    if (!in) {
+        error = "nie można otworzyć '" + path + "'";
+        return false;
+    }
+
+    bool incomplete = false;
+    if (!readHeader(error, incomplete)) {
+        if (incomplete) error = "'" + path + "' nie jest logiem metryk";
+        return false;
+    }
+    return true;
+}
+
+bool MetricsLog::Reader::readHeader(std::string& error, bool& incomplete) {
+    // Błąd odczytu na końcu pliku to nagłówek jeszcze dopisywany, nie uszkodzenie
+    const auto fail = [&](const char* what) {
+        incomplete = in.eof();
+        if (!incomplete) error = what;
+        return false;
+    };
+
+    uint8_t fixed[sizeof(MAGIC) + 16];
+    if (!in.read(reinterpret_cast<char*>(fixed), sizeof(fixed))) return fail("nie jest logiem metryk");
+    if (std::memcmp(fixed, MAGIC, sizeof(MAGIC)) != 0) {
+        error = "'" + filePath + "' nie jest logiem metryk";
+        return false;
+    }
+
+    const uint32_t version = getU32(fixed + 8);
+    if (version != VERSION) {
+        error = "nieobsługiwana wersja logu " + std::to_string(version);
+        return false;
+    }
+
+    Header h;
+    h.compressed = (getU32(fixed + 12) & 1u) != 0;
+    const uint32_t columnCount = getU32(fixed + 16);
+    const uint32_t paramsBytes = getU32(fixed + 20);
+
+    for (uint32_t c = 0; c < columnCount; ++c) {
+        uint8_t typeAndLength[2];
+        if (!in.read(reinterpret_cast<char*>(typeAndLength), 2)) return fail("uszkodzony schemat kolumn");
+        if (typeAndLength[0] > (uint8_t)ColumnType::Float64) {
+            error = "uszkodzony schemat kolumn";
+            return false;
+        }
+        std::string name(typeAndLength[1], '\0');
+        if (!in.read(name.data(), (std::streamsize)name.size())) return fail("uszkodzony schemat kolumn");
+        h.columns.push_back({ name, (ColumnType)typeAndLength[0] });
+    }
+    if (h.columns.empty() || h.columns[0].type != ColumnType::Int32) {
+        error = "log bez kolumny pokoleń";
+        return false;
+    }
+
+    std::string params(paramsBytes, '\0');
+    if (!in.read(params.data(), (std::streamsize)params.size())) return fail("uszkodzone parametry przebiegu");
+    size_t pos = 0;
+    while (pos < params.size()) {
+        size_t nl = params.find('\n', pos);
+        if (nl == std::string::npos) nl = params.size();
+        const std::string line = params.substr(pos, nl - pos);
+        const size_t eq = line.find('=');
+        if (eq != std::string::npos) h.params.emplace_back(line.substr(0, eq), line.substr(eq + 1));
+        pos = nl + 1;
+    }
+
+    schema = std::move(h);
+    payloadPending = false;
+    return true;
+}
+
+bool MetricsLog::Reader::nextBlock(Block& block, std::string& error) {
+    if (payloadPending) skipBlock();
+
+    for (;;) {
+        const std::streampos start = in.tellg();
+        std::error_code ec;
+        const uintmax_t size = std::filesystem::file_size(filePath, ec);
+        if (ec) {
+            error = "nie można odczytać rozmiaru '" + filePath + "'";
+            return false;
+        }
+        const uintmax_t available = size - (uintmax_t)start;
+        if (available == 0) return false;
+
+        // Dopisywany właśnie blok albo nagłówek (przebieg trwa): koniec na teraz, można spróbować później
+        const auto pending = [&] {
+            in.clear();
+            in.seekg(start);
+            return false;
+        };
+
+        uint8_t h[BLOCK_HEADER_BYTES];
+        const size_t prefix = (size_t)std::min<uintmax_t>(available, 4);
+        in.read(reinterpret_cast<char*>(h), (std::streamsize)prefix);
+
+        uint8_t blockMagic[4];
+        for (int i = 0; i < 4; ++i) blockMagic[i] = (uint8_t)((BLOCK_MAGIC >> (8 * i)) & 0xFF);
+        const bool isBlock = std::memcmp(h, blockMagic, prefix) == 0;
+        const bool isHeader = std::memcmp(h, MAGIC, prefix) == 0;
+
+        if (!isBlock && !isHeader) {
+            error = "nieczytelne dane w pozycji " + std::to_string((uintmax_t)start) + " (uszkodzony log)";
+            return false;
+        }
+        if (prefix < 4) return pending();
+
+        if (isHeader) {
+            // Kolejny nagłówek: nowy przebieg dopisany do tego samego pliku (reset albo ponowne uruchomienie)
+            in.seekg(start);
+            bool incomplete = false;
+            if (!readHeader(error, incomplete)) {
+                if (incomplete) return pending();
+                return false;
+            }
+            segmentIndex++;
+            continue;
+        }
+
+        if (available < BLOCK_HEADER_BYTES) return pending();
+        in.read(reinterpret_cast<char*>(h) + 4, BLOCK_HEADER_BYTES - 4);
+
+        payloadBytes = getU32(h + 16);
+        encoding = h[20];
+        if ((uintmax_t)BLOCK_HEADER_BYTES + payloadBytes > available) return pending();
+
+        blockRowCount = (int)getU32(h + 4);
+        block.rows = blockRowCount;
+        block.firstGeneration = (int32_t)getU32(h + 8);
+        block.lastGeneration = (int32_t)getU32(h + 12);
+        block.segment = segmentIndex;
+        block.offset = (uint64_t)start;
+        block.bytes = BLOCK_HEADER_BYTES + payloadBytes;
+        payloadPending = true;
+        return true;
+    }
+}
+
+void MetricsLog::Reader::skipBlock() {
+    if (!payloadPending) return;
+    in.seekg(payloadBytes, std::ios::cur);
+    payloadPending = false;
+}
+
+bool MetricsLog::Reader::readBlock(std::vector<std::vector<uint64_t>>& columns, std::string& error) {
+    if (!payloadPending) {
+        error = "brak bloku do odczytu";
+        return false;
+    }
+
+    std::vector<uint8_t> payload(payloadBytes);
+    if (!in.read(reinterpret_cast<char*>(payload.data()), (std::streamsize)payload.size())) {
+        error = "ucięty blok";
+        return false;
+    }
+    payloadPending = false;
+
+    const uint8_t* p = payload.data();
+    const uint8_t* end = p + payload.size();
+    const size_t n = (size_t)blockRowCount;
+
+    columns.resize(schema.columns.size());
+    for (size_t c = 0; c < schema.columns.size(); ++c) {
+        const ColumnType type = schema.columns[c].type;
+        std::vector<uint64_t>& out = columns[c];
+        out.resize(n);
+
+        if (encoding == RAW) {
+            const size_t bytes = valueBytes(type);
+            if ((size_t)(end - p) < n * bytes) {
+                error = "uszkodzony blok";
+                return false;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                uint64_t x = 0;
+                for (size_t b = 0; b < bytes; ++b) x |= (uint64_t)p[b] << (8 * b);
+                out[i] = x;
+                p += bytes;
+            }
+            continue;
+        }
+
+        uint64_t prev = 0;
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t x;
+            if (!getVarint(p, end, x)) {
+                error = "uszkodzony blok";
+                return false;
+            }
+            if (type == ColumnType::Int32) {
+                prev = (uint64_t)(uint32_t)(int32_t)((int64_t)(int32_t)(uint32_t)prev + unzigzag(x));
+            }
+            else {
+                prev ^= x;
+            }
+            out[i] = prev;
+        }
+    }
+    return true;
+}
+
+char* MetricsLog::Reader::formatValue(char* out, ColumnType type, uint64_t bits) {
+    switch (type) {
+    case ColumnType::Int32:
+        return std::to_chars(out, out + 16, (int32_t)(uint32_t)bits).ptr;
+    case ColumnType::Float32:
+        return std::to_chars(out, out + 32, (double)std::bit_cast<float>((uint32_t)bits), std::chars_format::general, 6).ptr;
+    case ColumnType::Float64:
+        return std::to_chars(out, out + 32, std::bit_cast<double>(bits), std::chars_format::general, 6).ptr;
+    }
+    return out;
+}
+
+// =========================
+// Obcinanie przy wznowieniu
+// =========================
+
+bool MetricsLog::truncateAfter(const std::string& path, int generation, std::string& error) {
+    Reader::Block block;
+    int lastKept = -1; // ostatni blok zaczynający się w zakresie
+    int index = 0;
+    uint64_t keepBytes = 0;
+    bool split = false;
+    {
+        Reader reader;
+        if (!reader.open(path, error)) return false;
+        for (; reader.nextBlock(block, error); ++index) {
+            if (block.firstGeneration > generation) continue;
+            lastKept = index;
+            split = block.lastGeneration > generation;
+            keepBytes = split ? block.offset : block.offset + block.bytes;
+        }
+        if (!error.empty()) return false;
+    }
+
+    // Blok na granicy: dekodujemy go jeszcze raz i zostawiamy tylko wiersze do punktu kontrolnego
+    std::string tail;
+    if (split) {
+        Reader reader;
+        std::vector<std::vector<uint64_t>> columns;
+        if (!reader.open(path, error)) return false;
+        for (int i = 0; i <= lastKept; ++i) {
+            if (!reader.nextBlock(block, error)) {
+                if (error.empty()) error = "log zmienił się w trakcie obcinania";
+                return false;
+            }
+        }
+        if (!reader.readBlock(columns, error)) return false;
+
+        Encoder encoder;
+        encoder.begin(reader.header(), block.rows);
+        std::vector<uint64_t> row(columns.size());
+        for (int r = 0; r < block.rows; ++r) {
+            if ((int32_t)(uint32_t)columns[0][(size_t)r] > generation) break;
+            for (size_t c = 0; c < columns.size(); ++c) row[c] = columns[c][(size_t)r];
+            encoder.push(row.data());
+        }
+        encoder.encodeBlock(tail);
+    }
+
+    std::error_code ec;
+    std::filesystem::resize_file(path, keepBytes, ec);
+    if (ec) {
+        error = "nie można obciąć '" + path + "': " + ec.message();
+        return false;
+    }
+    if (!tail.empty()) {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        if (!out.write(tail.data(), (std::streamsize)tail.size())) {
+            error = "nie można zapisać '" + path + "'";
+            return false;
+        }
+    }
+    return true;
+}
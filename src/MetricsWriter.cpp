@@ -0,0 +1,105 @@
+#include "MetricsWriter.hpp"
+
+MetricsWriter::~MetricsWriter() {
+    close();
+}
+
+bool MetricsWriter::open(const std::string& path, bool truncate) {
+    close();
+
+    file = std::fopen(path.c_str(), truncate ? "wb" : "ab");
+    if (!file) return false;
+
+    filePath = path;
+    writeFailed.store(false, std::memory_order_relaxed);
+    stopping = false;
+    backPending = false;
+
+    // Rezerwa z zapasem, żeby w stanie ustalonym dopisywanie nie alokowało
+    front.clear();
+    back.clear();
+    front.reserve(flushBytes * 2);
+    back.reserve(flushBytes * 2);
+
+    lastHandOff = std::chrono::steady_clock::now();
+    ioThread = std::thread(&MetricsWriter::ioLoop, this);
+    return true;
+}
+
+void MetricsWriter::close() {
+    if (!file) return;
+
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    ioThread.join();
+
+    std::fclose(file);
+    file = nullptr;
+    filePath.clear();
+}
+
+void MetricsWriter::setThresholds(size_t bytes, std::chrono::milliseconds interval) {
+    flushBytes = bytes > 0 ? bytes : 1;
+    flushInterval = interval;
+}
+
+void MetricsWriter::append(const char* data, size_t size) {
+    if (!file) return;
+
+    front.append(data, size);
+
+    const auto now = std::chrono::steady_clock::now();
+    if (front.size() >= flushBytes || now - lastHandOff >= flushInterval) {
+        if (handOff()) lastHandOff = now;
+    }
+}
+
+bool MetricsWriter::handOff() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (backPending) return false;
+        front.swap(back);
+        backPending = true;
+    }
+    wake.notify_one();
+    return true;
+}
+
+bool MetricsWriter::flush() {
+    if (!file) return !failed();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        written.wait(lock, [&] { return !backPending; });
+        if (front.empty()) break;
+
+        front.swap(back);
+        backPending = true;
+        wake.notify_one();
+    }
+    lastHandOff = std::chrono::steady_clock::now();
+    return !failed();
+}
+
+void MetricsWriter::ioLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    for (;;) {
+        wake.wait(lock, [&] { return backPending || stopping; });
+        if (!backPending) return; // stopping i nic do zapisu
+
+        // Właścicielem back jest teraz ten wątek; zapis bez trzymania blokady
+        lock.unlock();
+        const bool ok = std::fwrite(back.data(), 1, back.size(), file) == back.size() && std::fflush(file) == 0;
+        if (!ok) writeFailed.store(true, std::memory_order_relaxed);
+        back.clear();
+        lock.lock();
+
+        backPending = false;
+        written.notify_all();
+    }
+}
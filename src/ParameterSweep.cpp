@@ -0,0 +1,196 @@
+#include "ParameterSweep.hpp"
+#include "constants.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+    // SplitMix64: rozrzuca kolejne numery replikacji na niezależne ziarna
+    uint64_t splitmix64(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    bool parseDouble(const std::string& text, double& out) {
+        if (text.empty()) return false;
+        char* end = nullptr;
+        out = std::strtod(text.c_str(), &end);
+        return end == text.c_str() + text.size();
+    }
+
+    std::string formatValue(double v) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.6g", v);
+        return buf;
+    }
+
+    std::string trimmed(const std::string& s) {
+        size_t b = s.find_first_not_of(" \t");
+        size_t e = s.find_last_not_of(" \t");
+        return (b == std::string::npos) ? std::string() : s.substr(b, e - b + 1);
+    }
+
+    SweepResult runJob(const SimulationConfig::Entries& base, const SweepJob& job, int generations) {
+        SweepResult result;
+        result.job = job;
+
+        Simulation sim(GRID_WIDTH, GRID_HEIGHT, { 3.0f, 5.0f, 0.0f, 1.0f });
+        for (const auto& entries : { &base, &job.settings }) {
+            for (const auto& [key, value] : *entries) {
+                // Ziarno zadania wyznacza expand(); klucz nadpisany po cichu dałby mylący wynik
+                if (key == "seed") {
+                    result.error = "klucz 'seed' w ustawieniach zadania; ziarna wyznaczają seed bazowy i replikacje";
+                    return result;
+                }
+                if (!SimulationConfig::apply(sim, key, value, result.error)) return result;
+            }
+        }
+        sim.seed = job.seed;
+        sim.reset();
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int g = 0; g < generations; ++g) sim.step();
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        result.final = sim.lastMetrics;
+        result.ok = true;
+        return result;
+    }
+}
+
+namespace ParameterSweep {
+
+    bool parseAxis(const std::string& key, const std::string& spec, SweepAxis& out, std::string& error) {
+        out.key = key;
+        out.values.clear();
+
+        if (key == "seed") {
+            error = "oś 'seed' nie jest obsługiwana: ziarna zadań wynikają z 'seed' (ziarno bazowe) i 'replicates'";
+            return false;
+        }
+
+        size_t c1 = spec.find(':');
+        if (c1 != std::string::npos) {
+            size_t c2 = spec.find(':', c1 + 1);
+            double start, stop, step;
+            if (c2 == std::string::npos ||
+                !parseDouble(trimmed(spec.substr(0, c1)), start) ||
+                !parseDouble(trimmed(spec.substr(c1 + 1, c2 - c1 - 1)), stop) ||
+                !parseDouble(trimmed(spec.substr(c2 + 1)), step) ||
+                step <= 0.0 || stop < start) {
+                error = "zły zakres osi '" + key + "': '" + spec + "' (start:stop:krok)";
+                return false;
+            }
+
+            // Tolerancja, żeby 0.1-krokowe zakresy nie gubiły ostatniej wartości przez zaokrąglenia
+            const int count = (int)std::floor((stop - start) / step + 1e-9) + 1;
+            for (int i = 0; i < count; ++i) out.values.push_back(formatValue(start + i * step));
+        }
+        else {
+            size_t pos = 0;
+            while (pos <= spec.size()) {
+                size_t comma = spec.find(',', pos);
+                if (comma == std::string::npos) comma = spec.size();
+                std::string v = trimmed(spec.substr(pos, comma - pos));
+                if (!v.empty()) out.values.push_back(v);
+                pos = comma + 1;
+            }
+        }
+
+        if (out.values.empty()) {
+            error = "pusta oś '" + key + "'";
+            return false;
+        }
+        return true;
+    }
+
+    std::vector<SweepJob> expand(const std::vector<SweepAxis>& axes, int replicates, uint64_t baseSeed) {
+        size_t points = 1;
+        for (const SweepAxis& axis : axes) points *= axis.values.size();
+
+        std::vector<SweepJob> jobs;
+        jobs.reserve(points * (size_t)replicates);
+
+        for (size_t p = 0; p < points; ++p) {
+            // Ostatnia oś zmienia się najszybciej
+            SimulationConfig::Entries settings;
+            size_t rest = p;
+            for (size_t a = axes.size(); a-- > 0;) {
+                const SweepAxis& axis = axes[a];
+                settings.emplace_back(axis.key, axis.values[rest % axis.values.size()]);
+                rest /= axis.values.size();
+            }
+            std::reverse(settings.begin(), settings.end());
+
+            for (int r = 0; r < replicates; ++r) {
+                SweepJob job;
+                job.point = (int)p;
+                job.replicate = r;
+                job.seed = splitmix64(baseSeed + (uint64_t)r);
+                job.settings = settings;
+                jobs.push_back(std::move(job));
+            }
+        }
+        return jobs;
+    }
+
+    std::vector<SweepResult> run(const SimulationConfig::Entries& base, const std::vector<SweepJob>& jobs,
+        int generations, int threads, const std::function<void(const SweepResult&, size_t done)>& onDone) {
+
+        std::vector<SweepResult> results(jobs.size());
+        std::atomic<size_t> next{ 0 };
+        size_t done = 0;
+        std::mutex doneMutex;
+
+        auto worker = [&]() {
+#ifdef _OPENMP
+            // Jeden rdzeń na instancję: regiony równoległe w tym wątku mają 1 wątek
+            omp_set_num_threads(1);
+#endif
+            for (size_t i = next++; i < jobs.size(); i = next++) {
+                results[i] = runJob(base, jobs[i], generations);
+
+                if (onDone) {
+                    std::lock_guard<std::mutex> lock(doneMutex);
+                    onDone(results[i], ++done);
+                }
+            }
+        };
+
+        threads = std::max(1, std::min(threads, (int)jobs.size()));
+        std::vector<std::thread> pool;
+        pool.reserve(threads);
+        for (int t = 0; t < threads; ++t) pool.emplace_back(worker);
+        for (std::thread& t : pool) t.join();
+
+        return results;
+    }
+
+    void writeCsv(std::ostream& out, const std::vector<SweepAxis>& axes, const std::vector<SweepResult>& results) {
+        for (const SweepAxis& axis : axes) out << axis.key << ",";
+        out << "Point,Replicate,Seed,Seconds,";
+        writeMetricsCsvHeader(out);
+        out << "\n";
+
+        for (const SweepResult& r : results) {
+            if (!r.ok) continue;
+            for (const auto& entry : r.job.settings) out << entry.second << ",";
+            out << r.job.point << "," << r.job.replicate << "," << r.job.seed << "," << r.seconds << ",";
+            writeMetricsCsvRow(out, r.final);
+            out << "\n";
+        }
+    }
+}
@@ -0,0 +1,178 @@
+#include "RoundKernel.hpp"
+#include "Agent.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ROUND_KERNEL_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ROUND_KERNEL_SSE2 1
+#endif
+
+namespace RoundKernel {
+
+    static inline uint8_t pavlovNext(uint8_t m, uint8_t t, const PavlovRule& r) {
+        uint8_t stay = (uint8_t)((~m & ~t & r.stayCC) | (~m & t & r.stayCD) | (m & ~t & r.stayDC) | (m & t & r.stayDD));
+        return (uint8_t)(m ^ ~stay);
+    }
+
+    static inline uint8_t decideScalar(uint8_t type, uint8_t slots, uint8_t m, uint8_t t, uint8_t disc, const PavlovRule& r) {
+        uint8_t d = 0;
+        switch ((AgentType)type) {
+        case AgentType::AlwaysCooperate: d = 0; break;
+        case AgentType::AlwaysDefect:    d = 0xFF; break;
+        case AgentType::TitForTat:       d = t; break;
+        case AgentType::Pavlov:          d = pavlovNext(m, t, r); break;
+        case AgentType::Discriminator:   d = disc; break;
+        }
+        return (uint8_t)(d & slots);
+    }
+
+#if defined(ROUND_KERNEL_AVX2)
+    static inline __m256i popcount8x32(__m256i v) {
+        const __m256i m1 = _mm256_set1_epi8(0x55);
+        const __m256i m2 = _mm256_set1_epi8(0x33);
+        const __m256i m4 = _mm256_set1_epi8(0x0F);
+        v = _mm256_sub_epi8(v, _mm256_and_si256(_mm256_srli_epi16(v, 1), m1));
+        v = _mm256_add_epi8(_mm256_and_si256(v, m2), _mm256_and_si256(_mm256_srli_epi16(v, 2), m2));
+        return _mm256_and_si256(_mm256_add_epi8(v, _mm256_srli_epi16(v, 4)), m4);
+    }
+#elif defined(ROUND_KERNEL_SSE2)
+    static inline __m128i popcount8x16(__m128i v) {
+        const __m128i m1 = _mm_set1_epi8(0x55);
+        const __m128i m2 = _mm_set1_epi8(0x33);
+        const __m128i m4 = _mm_set1_epi8(0x0F);
+        v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi16(v, 1), m1));
+        v = _mm_add_epi8(_mm_and_si128(v, m2), _mm_and_si128(_mm_srli_epi16(v, 2), m2));
+        return _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi16(v, 4)), m4);
+    }
+#endif
+
+    void decide(const uint8_t* type, const uint8_t* activeSlots,
+        const uint8_t* myLast, const uint8_t* theirLast, const uint8_t* discBits,
+        uint8_t* out, int n, PavlovRule rule) {
+
+        int i = 0;
+
+#if defined(ROUND_KERNEL_AVX2)
+        const __m256i allD = _mm256_set1_epi8((char)AgentType::AlwaysDefect);
+        const __m256i tft = _mm256_set1_epi8((char)AgentType::TitForTat);
+        const __m256i pav = _mm256_set1_epi8((char)AgentType::Pavlov);
+        const __m256i disc = _mm256_set1_epi8((char)AgentType::Discriminator);
+        const __m256i sCC = _mm256_set1_epi8((char)rule.stayCC);
+        const __m256i sCD = _mm256_set1_epi8((char)rule.stayCD);
+        const __m256i sDC = _mm256_set1_epi8((char)rule.stayDC);
+        const __m256i sDD = _mm256_set1_epi8((char)rule.stayDD);
+        const __m256i ones = _mm256_set1_epi8((char)0xFF);
+
+        for (; i + 32 <= n; i += 32) {
+            __m256i ty = _mm256_loadu_si256((const __m256i*)(type + i));
+            __m256i sl = _mm256_loadu_si256((const __m256i*)(activeSlots + i));
+            __m256i m = _mm256_loadu_si256((const __m256i*)(myLast + i));
+            __m256i t = _mm256_loadu_si256((const __m256i*)(theirLast + i));
+            __m256i ds = _mm256_loadu_si256((const __m256i*)(discBits + i));
+
+            __m256i nm = _mm256_xor_si256(m, ones);
+            __m256i nt = _mm256_xor_si256(t, ones);
+            __m256i stay = _mm256_or_si256(
+                _mm256_or_si256(_mm256_and_si256(_mm256_and_si256(nm, nt), sCC), _mm256_and_si256(_mm256_and_si256(nm, t), sCD)),
+                _mm256_or_si256(_mm256_and_si256(_mm256_and_si256(m, nt), sDC), _mm256_and_si256(_mm256_and_si256(m, t), sDD)));
+            __m256i pavD = _mm256_xor_si256(m, _mm256_xor_si256(stay, ones));
+
+            __m256i d = _mm256_cmpeq_epi8(ty, allD);
+            d = _mm256_or_si256(d, _mm256_and_si256(_mm256_cmpeq_epi8(ty, tft), t));
+            d = _mm256_or_si256(d, _mm256_and_si256(_mm256_cmpeq_epi8(ty, pav), pavD));
+            d = _mm256_or_si256(d, _mm256_and_si256(_mm256_cmpeq_epi8(ty, disc), ds));
+
+            _mm256_storeu_si256((__m256i*)(out + i), _mm256_and_si256(d, sl));
+        }
+#elif defined(ROUND_KERNEL_SSE2)
+        const __m128i allD = _mm_set1_epi8((char)AgentType::AlwaysDefect);
+        const __m128i tft = _mm_set1_epi8((char)AgentType::TitForTat);
+        const __m128i pav = _mm_set1_epi8((char)AgentType::Pavlov);
+        const __m128i disc = _mm_set1_epi8((char)AgentType::Discriminator);
+        const __m128i sCC = _mm_set1_epi8((char)rule.stayCC);
+        const __m128i sCD = _mm_set1_epi8((char)rule.stayCD);
+        const __m128i sDC = _mm_set1_epi8((char)rule.stayDC);
+        const __m128i sDD = _mm_set1_epi8((char)rule.stayDD);
+        const __m128i ones = _mm_set1_epi8((char)0xFF);
+
+        for (; i + 16 <= n; i += 16) {
+            __m128i ty = _mm_loadu_si128((const __m128i*)(type + i));
+            __m128i sl = _mm_loadu_si128((const __m128i*)(activeSlots + i));
+            __m128i m = _mm_loadu_si128((const __m128i*)(myLast + i));
+            __m128i t = _mm_loadu_si128((const __m128i*)(theirLast + i));
+            __m128i ds = _mm_loadu_si128((const __m128i*)(discBits + i));
+
+            __m128i nm = _mm_xor_si128(m, ones);
+            __m128i nt = _mm_xor_si128(t, ones);
+            __m128i stay = _mm_or_si128(
+                _mm_or_si128(_mm_and_si128(_mm_and_si128(nm, nt), sCC), _mm_and_si128(_mm_and_si128(nm, t), sCD)),
+                _mm_or_si128(_mm_and_si128(_mm_and_si128(m, nt), sDC), _mm_and_si128(_mm_and_si128(m, t), sDD)));
+            __m128i pavD = _mm_xor_si128(m, _mm_xor_si128(stay, ones));
+
+            __m128i d = _mm_cmpeq_epi8(ty, allD);
+            d = _mm_or_si128(d, _mm_and_si128(_mm_cmpeq_epi8(ty, tft), t));
+            d = _mm_or_si128(d, _mm_and_si128(_mm_cmpeq_epi8(ty, pav), pavD));
+            d = _mm_or_si128(d, _mm_and_si128(_mm_cmpeq_epi8(ty, disc), ds));
+
+            _mm_storeu_si128((__m128i*)(out + i), _mm_and_si128(d, sl));
+        }
+#endif
+
+        for (; i < n; ++i) {
+            out[i] = decideScalar(type[i], activeSlots[i], myLast[i], theirLast[i], discBits[i], rule);
+        }
+    }
+
+    void countOutcomes(const uint8_t* my, const uint8_t* his, const uint8_t* occupied,
+        uint8_t* nCC, uint8_t* nCD, uint8_t* nDC, uint8_t* nDD, int n) {
+
+        int i = 0;
+
+#if defined(ROUND_KERNEL_AVX2)
+        for (; i + 32 <= n; i += 32) {
+            __m256i occ = _mm256_loadu_si256((const __m256i*)(occupied + i));
+            __m256i m = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(my + i)), occ);
+            __m256i h = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(his + i)), occ);
+
+            // andnot(a, b) = ~a & b
+            __m256i cc = _mm256_andnot_si256(_mm256_or_si256(m, h), occ);
+            __m256i cd = _mm256_andnot_si256(m, h);
+            __m256i dc = _mm256_andnot_si256(h, m);
+            __m256i dd = _mm256_and_si256(m, h);
+
+            _mm256_storeu_si256((__m256i*)(nCC + i), popcount8x32(cc));
+            _mm256_storeu_si256((__m256i*)(nCD + i), popcount8x32(cd));
+            _mm256_storeu_si256((__m256i*)(nDC + i), popcount8x32(dc));
+            _mm256_storeu_si256((__m256i*)(nDD + i), popcount8x32(dd));
+        }
+#elif defined(ROUND_KERNEL_SSE2)
+        for (; i + 16 <= n; i += 16) {
+            __m128i occ = _mm_loadu_si128((const __m128i*)(occupied + i));
+            __m128i m = _mm_and_si128(_mm_loadu_si128((const __m128i*)(my + i)), occ);
+            __m128i h = _mm_and_si128(_mm_loadu_si128((const __m128i*)(his + i)), occ);
+
+            // andnot(a, b) = ~a & b
+            __m128i cc = _mm_andnot_si128(_mm_or_si128(m, h), occ);
+            __m128i cd = _mm_andnot_si128(m, h);
+            __m128i dc = _mm_andnot_si128(h, m);
+            __m128i dd = _mm_and_si128(m, h);
+
+            _mm_storeu_si128((__m128i*)(nCC + i), popcount8x16(cc));
+            _mm_storeu_si128((__m128i*)(nCD + i), popcount8x16(cd));
+            _mm_storeu_si128((__m128i*)(nDC + i), popcount8x16(dc));
+            _mm_storeu_si128((__m128i*)(nDD + i), popcount8x16(dd));
+        }
+#endif
+
+        for (; i < n; ++i) {
+            uint8_t m = my[i] & occupied[i];
+            uint8_t h = his[i] & occupied[i];
+            nCC[i] = (uint8_t)popcount8((uint8_t)(~(m | h) & occupied[i]));
+            nCD[i] = (uint8_t)popcount8((uint8_t)(~m & h));
+            nDC[i] = (uint8_t)popcount8((uint8_t)(m & ~h));
+            nDD[i] = (uint8_t)popcount8((uint8_t)(m & h));
+        }
+    }
+}
@@ -1,19 +1,70 @@
 #include "Simulation.hpp"
+#include "SimulationConfig.hpp"
+#include "RoundKernel.hpp"
+#include "Stencil.hpp"
+#include "AllocationCounter.hpp"
+#include "FastMath.hpp"
+#include "Trace.hpp"
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <charconv>
 #include <cmath>
+#include <filesystem>
 #include <fstream>
+#include <random>
+#include <sstream>
+
+// Rozmiar bloku komórek dla jąder wektorowych (podział pracy między wątki)
+static constexpr int KERNEL_BLOCK = 4096;
+static_assert(KERNEL_BLOCK % 64 == 0, "blok musi obejmować całe słowa bitsetu AgentStore::changed");
 
 static float fitnessFromPayoff(float payoff, float beta) {
     return std::exp(beta * payoff);
 }
 
 Simulation::Simulation(int width, int height, PayoffMatrix m)
-    : grid(width, height), matrix(m), rng(std::random_device{}()) {
-    
+    : grid(width, height), matrix(m) {
+
+    // Domyślnie losowe ziarno (można je potem ustawić ręcznie i zrobić reset)
+    randomizeSeed();
+
     // Konstruktor tylko inicjalizuje, resztę robi reset
     reset();
 }
 
+Simulation::~Simulation() {
+    // Ostatnie wiersze (i niepełny blok logu) trafiają do pliku przed zamknięciem
+    closeMetricsFile();
+}
+
+void Simulation::prepareScratch() {
+    const size_t cells = (size_t)grid.cellCount();
+    if (scratch.decisions.size() == cells) return;
+
+    scratch.activeSlots.assign(cells, 0);
+    scratch.occupiedSlots.assign(cells, 0);
+    scratch.discBits.assign(cells, 0);
+    scratch.decisions.assign(cells, 0);
+    scratch.hisBits.assign(cells, 0);
+    scratch.nCC.assign(cells, 0);
+    scratch.nCD.assign(cells, 0);
+    scratch.nDC.assign(cells, 0);
+    scratch.nDD.assign(cells, 0);
+    scratch.roundPayoff.assign(cells, 0.0f);
+    scratch.order.clear();
+    scratch.order.reserve(cells);
+    scratch.nextTypes.assign(cells, AgentType::AlwaysCooperate);
+    scratch.imitPartner.assign(cells, -1);
+    scratch.imitArg.assign(cells, 0.0f);
+    scratch.imitDraw.assign(cells, 0.0f);
+    scratch.born.assign(cells, 0);
+    scratch.moveTarget.assign(cells, -1);
+    scratch.moveClaim.assign(cells, 0);
+    scratch.blockTraits.assign((cells + KERNEL_BLOCK - 1) / KERNEL_BLOCK, TraitSums{});
+}
+
 float Simulation::payoffVs(Action a, Action b) const {
     if (a == Action::Cooperate && b == Action::Cooperate) return matrix.R;
     if (a == Action::Cooperate && b == Action::Defect)    return matrix.S;
@@ -21,222 +72,400 @@ float Simulation::payoffVs(Action a, Action b) const {
     return matrix.P;
 }
 
-float Simulation::expectedPayoffAt(int x, int y, Action s) const {
+template <class Nb>
+float Simulation::expectedPayoffAt(int idx, const Nb& nb, Action s) const {
     float sum = 0.0f;
     int k = 0;
-    auto neigh = grid.getNeighborCoords(x, y);
-    for (auto [nx, ny] : neigh) {
-        const Agent* n = grid.get(nx, ny);
-        if (!n) continue;
-        sum += payoffVs(s, n->currentAction);
+    const int count = nb.countAt(idx);
+    for (int i = 0; i < count; ++i) {
+        int n = nb.neighbor(idx, i);
+        if (!agents.occupied(n)) continue;
+        sum += payoffVs(s, agents.currentAction[n]);
         k++;
     }
     return (k > 0) ? (sum / (float)k) : 0.0f;
 }
 
 void Simulation::playOneRound() {
-    const int W = grid.width;
-    const int H = grid.height;
+    Trace::Scope roundTrace("Round");
+    traitsCurrent = false; // payoff, reputacja i akcje się zmieniają
+    const int cells = grid.cellCount();
+    const int height = grid.height;
 
-    std::vector<float> outcomes = { matrix.R, matrix.T, matrix.S, matrix.P };
+    std::array<float, 4> outcomes = { matrix.R, matrix.T, matrix.S, matrix.P };
 
     std::sort(outcomes.begin(), outcomes.end());
 
     float pavlovThreshold = (outcomes[1] + outcomes[2]) / 2.0f;
 
-    struct AgentDecisions {
-        std::vector<Action> actions;
+    // Pavlov: zostań przy akcji, jeśli wynik ostatniej gry >= próg (CC->R, CD->S, DC->T, DD->P)
+    RoundKernel::PavlovRule pavlov = {
+        (uint8_t)(matrix.R >= pavlovThreshold ? 0xFF : 0x00),
+        (uint8_t)(matrix.S >= pavlovThreshold ? 0xFF : 0x00),
+        (uint8_t)(matrix.T >= pavlovThreshold ? 0xFF : 0x00),
+        (uint8_t)(matrix.P >= pavlovThreshold ? 0xFF : 0x00)
     };
-    std::vector<AgentDecisions> currentDecisions(W * H);
+
+    // Spakowane plansze: jeden bajt na komórkę, bit i = slot i (1 = Defect)
+    std::vector<uint8_t>& activeSlots = scratch.activeSlots;
+    std::vector<uint8_t>& occupiedSlots = scratch.occupiedSlots;
+    std::vector<uint8_t>& discBits = scratch.discBits;
+    std::vector<uint8_t>& decisions = scratch.decisions;
 
     // KROK 1: Decyzje
-#pragma omp parallel for collapse(2)
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            Agent* me = grid.get(x, y);
-            if (!me) continue;
+    PhaseSpan decideSpan(timers, Phase::RoundDecide);
+
+    // 1a) Pamięć: reset slotów, w których siedzi ktoś nowy (lub puste pole), maski i reputacje sąsiadów
+    auto prepareCell = [&](int idx, const auto& nb) {
+        if (!agents.occupied(idx)) {
+            activeSlots[idx] = 0;
+            occupiedSlots[idx] = 0;
+            discBits[idx] = 0;
+            return;
+        }
 
-            int myIdx = y * W + x;
-            auto neighborsCoords = grid.getNeighborCoords(x, y);
+        const int count = nb.countAt(idx);
 
-            if (me->memory.size() != neighborsCoords.size()) {
-                me->resetMemory((int)neighborsCoords.size());
-            }
+        if (agents.memorySize[idx] != count) {
+            agents.resetMemory(idx, count);
+        }
 
-            currentDecisions[myIdx].actions.resize(neighborsCoords.size());
-            int coopCount = 0;
+        int32_t* partners = agents.partnersOf(idx);
+        uint8_t occupied = 0, disc = 0, stale = 0;
 
-            for (size_t i = 0; i < neighborsCoords.size(); ++i) {
-                auto [nx, ny] = neighborsCoords[i];
-                Agent* neighbor = grid.get(nx, ny);
+        for (int i = 0; i < count; ++i) {
+            int n = nb.neighbor(idx, i);
+            bool hasNeighbor = agents.occupied(n);
+            int currentNeighborId = hasNeighbor ? agents.id[n] : -1;
+            uint8_t bit = (uint8_t)(1u << i);
 
-                int currentNeighborId = (neighbor) ? neighbor->id : -1;
+            // Sprawdzamy, czy w pamięci na slocie [i] mamy tego samego agenta
+            if (partners[i] != currentNeighborId) {
+                partners[i] = currentNeighborId;
+                stale |= bit;
+            }
 
-                // Sprawdzamy, czy w pamięci na slocie [i] mamy tego samego agenta
-                if (me->memory[i].agentId != currentNeighborId) {
-                    // To jest ktoś nowy (lub puste pole)! Resetujemy relację.
-                    me->memory[i].agentId = currentNeighborId;
-                    me->memory[i].myLastAction = Action::Cooperate;
-                    me->memory[i].theirLastAction = Action::Cooperate;
-                }
-                // --------------------------
+            if (hasNeighbor) {
+                occupied |= bit;
+                if (agents.reputation[n] < reputationThreshold) disc |= bit;
+            }
+        }
 
-                Action act = me->decideAction((int)i, neighbor, matrix, pavlovThreshold, reputationThreshold);
-                currentDecisions[myIdx].actions[i] = act;
+        // Nowa relacja zaczyna od obustronnej współpracy
+        agents.myLastBits[idx] &= (uint8_t)~stale;
+        agents.theirLastBits[idx] &= (uint8_t)~stale;
 
-                if (act == Action::Cooperate) coopCount++;
-            }
+        activeSlots[idx] = (uint8_t)((1u << count) - 1u);
+        occupiedSlots[idx] = occupied;
+        discBits[idx] = disc;
+    };
 
-            if (neighborsCoords.size() > 0) {
-                float ratio = (float)coopCount / (float)neighborsCoords.size();
-                me->visualAction = (ratio >= 0.5f) ? Action::Cooperate : Action::Defect;
-            }
-            else {
-                me->visualAction = Action::Cooperate;
+    // Sekcje OpenMP rundy: każdy wątek zapisuje w śladzie swój odcinek pracy (nowait, żeby
+    // oczekiwanie na barierze było widać jako przerwę, a nie jako pracę)
+    Stencil::dispatch(grid, [&](const auto& view) {
+#pragma omp parallel
+        {
+            Trace::Scope work("Prepare");
+#pragma omp for nowait
+            for (int y = 0; y < height; ++y) view.forRow(y, prepareCell);
+        }
+    });
+
+    // 1b) Decyzje wszystkich strategii naraz (jądro wektorowe, bloki po KERNEL_BLOCK komórek)
+    const int blocks = (cells + KERNEL_BLOCK - 1) / KERNEL_BLOCK;
+#pragma omp parallel
+    {
+        Trace::Scope work("Decide");
+#pragma omp for nowait
+        for (int blk = 0; blk < blocks; ++blk) {
+            int begin = blk * KERNEL_BLOCK;
+            int n = std::min(KERNEL_BLOCK, cells - begin);
+            RoundKernel::decide(reinterpret_cast<const uint8_t*>(agents.type.data()) + begin, activeSlots.data() + begin,
+                agents.myLastBits.data() + begin, agents.theirLastBits.data() + begin, discBits.data() + begin,
+                decisions.data() + begin, n, pavlov);
+
+            // Dominująca akcja (do rysowania i jako akcja "globalna"). Blok zaczyna się na granicy
+            // słowa bitsetu zmian, więc jego słowa należą tylko do tego wątku i nie trzeba atomiców.
+            for (int idx = begin; idx < begin + n; ++idx) {
+                int count = RoundKernel::popcount8(activeSlots[idx]);
+                int defects = RoundKernel::popcount8(decisions[idx]);
+                const Action visual = (count == 0 || 2 * (count - defects) >= count) ? Action::Cooperate : Action::Defect;
+                if (visual != agents.visualAction[idx] && agents.occupied(idx)) {
+                    agents.changed[idx >> 6] |= 1ull << (idx & 63);
+                }
+                agents.visualAction[idx] = visual;
             }
         }
     }
 
+    decideSpan.end();
+
     // KROK 2: Wypłaty i aktualizacja pamięci
-    std::vector<float> roundPayoff(W * H, 0.0f);
-    std::vector<int> roundK(W * H, 0);
-
-#pragma omp parallel for collapse(2)
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            Agent* me = grid.get(x, y);
-            if (!me) continue;
-
-            int myIdx = y * W + x;
-            auto neighborsCoords = grid.getNeighborCoords(x, y);
-
-            float sum = 0.0f;
-            int k = 0;
-            float cooperatedCount = 0.0f;
-
-            for (size_t i = 0; i < neighborsCoords.size(); ++i) {
-                auto [nx, ny] = neighborsCoords[i];
-                Agent* neighbor = grid.get(nx, ny);
-
-                // Jeśli sąsiad zniknął (jest nullptr), ale my pamiętamy ID, to w następnej turze
-                // (Krok 1) zostanie to wyłapane i zresetowane.
-                if (!neighbor) {
-                    me->memory[i].agentId = -1;
-                    continue;
-                }
+    PhaseSpan payoffSpan(timers, Phase::RoundPayoff);
+
+    std::vector<uint8_t>& hisBits = scratch.hisBits;
+    std::vector<uint8_t>& nCC = scratch.nCC;
+    std::vector<uint8_t>& nCD = scratch.nCD;
+    std::vector<uint8_t>& nDC = scratch.nDC;
+    std::vector<uint8_t>& nDD = scratch.nDD;
+    std::vector<float>& roundPayoff = scratch.roundPayoff;
+
+    // 2a) Akcja sąsiada wobec mnie: bit ze slotu zwrotnego
+    auto gatherCell = [&](int idx, const auto& nb) {
+        uint8_t occupied = occupiedSlots[idx];
+        if (!occupied) {
+            hisBits[idx] = 0;
+            return;
+        }
 
-                Action myAction = currentDecisions[myIdx].actions[i];
+        const int count = nb.countAt(idx);
+        uint8_t his = 0;
 
-                // Znajdowanie akcji sąsiada (bez zmian)
-                int neighborIdx = ny * W + nx;
-                auto neighborsOfNeighbor = grid.getNeighborCoords(nx, ny);
-                int meInNeighborList = -1;
-                for (size_t j = 0; j < neighborsOfNeighbor.size(); ++j) {
-                    if (neighborsOfNeighbor[j].first == x && neighborsOfNeighbor[j].second == y) {
-                        meInNeighborList = (int)j;
-                        break;
-                    }
-                }
+        for (int i = 0; i < count; ++i) {
+            const int reverse = nb.reverse(idx, i);
+            if (!(occupied & (1u << i)) || reverse < 0) continue; // brak pary = współpraca
+            his |= (uint8_t)(((decisions[nb.neighbor(idx, i)] >> reverse) & 1u) << i);
+        }
+        hisBits[idx] = his;
+    };
 
-                Action hisAction = Action::Cooperate;
-                if (meInNeighborList != -1) {
-                    hisAction = currentDecisions[neighborIdx].actions[meInNeighborList];
-                }
+    Stencil::dispatch(grid, [&](const auto& view) {
+#pragma omp parallel
+        {
+            Trace::Scope work("Gather");
+#pragma omp for nowait
+            for (int y = 0; y < height; ++y) view.forRow(y, gatherCell);
+        }
+    });
 
-                sum += payoffVs(myAction, hisAction);
-                k++;
+    // 2b) Zliczenie wyników R/S/T/P (jądro wektorowe), wypłata, reputacja i pamięć
+#pragma omp parallel
+    {
+        Trace::Scope work("Payoff");
+#pragma omp for nowait
+        for (int blk = 0; blk < blocks; ++blk) {
+            int begin = blk * KERNEL_BLOCK;
+            int n = std::min(KERNEL_BLOCK, cells - begin);
+            RoundKernel::countOutcomes(decisions.data() + begin, hisBits.data() + begin, occupiedSlots.data() + begin,
+                nCC.data() + begin, nCD.data() + begin, nDC.data() + begin, nDD.data() + begin, n);
 
-                // Aktualizacja pamięci
-                me->memory[i].myLastAction = myAction;
-                me->memory[i].theirLastAction = hisAction;
+            for (int idx = begin; idx < begin + n; ++idx) {
+                if (!agents.occupied(idx)) continue;
 
-                if (myAction == Action::Cooperate) cooperatedCount++;
-            }
+                int k = nCC[idx] + nCD[idx] + nDC[idx] + nDD[idx];
+                float sum = matrix.R * nCC[idx] + matrix.S * nCD[idx] + matrix.T * nDC[idx] + matrix.P * nDD[idx];
+
+                roundPayoff[idx] = normalizePayoff ? ((k > 0) ? (sum / (float)k) : 0.0f) : sum;
 
-            roundPayoff[myIdx] = normalizePayoff ? ((k > 0) ? (sum / (float)k) : 0.0f) : sum;
-            roundK[myIdx] = k;
+                if (k > 0) {
+                    float coopRatio = (float)(nCC[idx] + nCD[idx]) / (float)k;
+                    agents.reputation[idx] = (1.0f - reputationAlpha) * agents.reputation[idx] + reputationAlpha * coopRatio;
+                }
 
-            if (k > 0) {
-                float coopRatio = cooperatedCount / (float)k;
-                me->reputation = (1.0f - reputationAlpha) * me->reputation + reputationAlpha * coopRatio;
+                // Aktualizacja pamięci tylko dla slotów, w których ktoś zagrał
+                uint8_t occupied = occupiedSlots[idx];
+                agents.myLastBits[idx] = (uint8_t)((agents.myLastBits[idx] & ~occupied) | (decisions[idx] & occupied));
+                agents.theirLastBits[idx] = (uint8_t)((agents.theirLastBits[idx] & ~occupied) | (hisBits[idx] & occupied));
             }
         }
     }
 
+    payoffSpan.end();
+
     // KROK 3: Aplikacja wypłat
-#pragma omp parallel for collapse(2)
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            Agent* a = grid.get(x, y);
-            if (a) {
-                int idx = y * W + x;
-                a->payoff += roundPayoff[idx];
-                a->lastPayoff = roundPayoff[idx];
-                a->lastAction = a->visualAction;
-                a->currentAction = a->visualAction;
+    PhaseSpan applySpan(timers, Phase::RoundApply);
+
+    // Akcje zmieniają się wszędzie, więc licznik współpracujących to redukcja w tym samym przejściu
+    int cooperators = 0;
+#pragma omp parallel reduction(+:cooperators)
+    {
+        Trace::Scope work("Apply");
+#pragma omp for nowait
+        for (int idx = 0; idx < cells; ++idx) {
+            if (agents.occupied(idx)) {
+                agents.payoff[idx] += roundPayoff[idx];
+                agents.lastPayoff[idx] = roundPayoff[idx];
+                agents.lastAction[idx] = agents.visualAction[idx];
+                agents.currentAction[idx] = agents.visualAction[idx];
+                if (agents.visualAction[idx] == Action::Cooperate) cooperators++;
             }
         }
     }
+    population.coop = cooperators;
+
+    applySpan.end();
+}
+
+void Simulation::randomizeSeed() {
+    seed = randomSeed();
+}
+
+uint64_t Simulation::randomSeed() {
+    std::random_device rd;
+    return ((uint64_t)rd() << 32) | rd();
+}
+
+CellRng Simulation::cellRng(int idx, RngPhase phase) const {
+    return CellRng(seed, (uint32_t)generation, (uint32_t)idx, phase);
+}
+
+template <class View, class Nb>
+int Simulation::chooseMoveTarget(const View& view, int idx, const Nb& nb) const {
+    const Action myAction = agents.currentAction[idx];
+    float current = expectedPayoffAt(idx, nb, myAction);
+
+    // znajdź puste pola w sąsiedztwie (r=1)
+    const int count = nb.countAt(idx);
+
+    // wybierz najlepsze puste miejsce (największy expected payoff)
+    float bestVal = current;
+    int bestPos = idx;
+
+    for (int i = 0; i < count; ++i) {
+        int e = nb.neighbor(idx, i);
+        if (agents.occupied(e)) continue;
+        float val = view.visit(e, [&](int cell, const auto& nbE) { return expectedPayoffAt(cell, nbE, myAction); });
+        if (val > bestVal + moveEpsilon) {
+            bestVal = val;
+            bestPos = e;
+        }
+    }
+    return bestPos;
+}
+
+template <class Nb>
+bool Simulation::chooseNewborn(int idx, const Nb& nb, AgentType& childType) const {
+    CellRng rng = cellRng(idx, RngPhase::Birth);
+    if (rng.uniform() > reproductionProb) return false;
+
+    const int count = nb.countAt(idx);
+
+    int parents[AgentStore::MaxNeighbors];
+    float w[AgentStore::MaxNeighbors];
+    int parentCount = 0;
+    float sumW = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        int p = nb.neighbor(idx, i);
+        if (!agents.occupied(p)) continue;
+        parents[parentCount] = p;
+        w[parentCount] = fitnessFromPayoff(agents.payoff[p], selectionBeta);
+        sumW += w[parentCount];
+        parentCount++;
+    }
+    if (parentCount == 0 || sumW <= 0.0f) return false;
+
+    float rr = rng.uniform() * sumW;
+    int chosen = 0;
+    for (int i = 0; i < parentCount; ++i) {
+        rr -= w[i];
+        if (rr <= 0.0f) { chosen = i; break; }
+    }
+
+    // DZIEDZICZENIE: typ od rodzica, dziecko zaczyna czysto (nowe ID, reputacja neutralna)
+    childType = agents.type[parents[chosen]];
+
+    // MUTACJA typu
+    if (mutationRate > 0.0f) {
+        if (rng.uniform() < mutationRate) {
+            childType = allowedTypes[rng.below((int)allowedTypes.size())];
+        }
+    }
+    return true;
 }
 
 void Simulation::step() {
-    std::uniform_real_distribution<float> uni01(0.f, 1.f);
+    Trace::Scope generationTrace("Generation");
+    timers.beginGeneration();
+
+    // Tablica sąsiedztwa mogła się zdezaktualizować (zmiana granic/sąsiedztwa w GUI)
+    grid.updateTopology();
+    prepareScratch();
+
+    // W stanie ustalonym pokolenie nie alokuje (sprawdzane w buildach z licznikiem alokacji),
+    // także w regionach równoległych, więc liczymy cały zespół OpenMP
+    [[maybe_unused]] const uint64_t allocationsBefore = AllocationCounter::teamCount();
+
+    const int cells = grid.cellCount();
 
     // =========================
     // FAZA 1: RUCH (raz na pokolenie, success-driven, r=1)
     // =========================
-    {
-        std::vector<std::pair<int, int>> order;
-        order.reserve(grid.width * grid.height);
-        for (int y = 0; y < grid.height; ++y)
-            for (int x = 0; x < grid.width; ++x)
-                order.emplace_back(x, y);
-
-        std::shuffle(order.begin(), order.end(), rng);
-
-        for (auto [x, y] : order) {
-            Agent* a = grid.get(x, y);
-            if (!a) continue;
-            if (uni01(rng) > moveProb) continue;
-
-            float current = expectedPayoffAt(x, y, a->currentAction);
-
-            // znajdź puste pola w sąsiedztwie (r=1)
-            auto neigh = grid.getNeighborCoords(x, y);
-            std::vector<std::pair<int, int>> empties;
-            empties.reserve(neigh.size());
-            for (auto [nx, ny] : neigh) {
-                if (grid.get(nx, ny) == nullptr) {
-                    empties.emplace_back(nx, ny);
-                }
-            }
-            if (empties.empty()) continue;
+    PhaseSpan movementSpan(timers, Phase::Movement);
+
+    if (migrationScheduling == UpdateScheduling::Serial) {
+        // Tasujemy tylko zajęte pola (puste i tak by odpadły)
+        std::vector<int>& order = scratch.order;
+        order.clear();
+        for (int idx = 0; idx < cells; ++idx) {
+            if (agents.occupied(idx)) order.push_back(idx);
+        }
 
-            // wybierz najlepsze puste miejsce (największy expected payoff)
-            float bestVal = current;
-            std::pair<int, int> bestPos = { x, y };
+        // Fisher-Yates na jednym strumieniu (faza jest szeregowa, więc kolejność jest stała)
+        CellRng orderRng = cellRng(0, RngPhase::MovementOrder);
+        for (int i = (int)order.size() - 1; i > 0; --i) {
+            std::swap(order[i], order[orderRng.below(i + 1)]);
+        }
 
-            for (auto [ex, ey] : empties) {
-                float val = expectedPayoffAt(ex, ey, a->currentAction);
-                if (val > bestVal + moveEpsilon) {
-                    bestVal = val;
-                    bestPos = { ex, ey };
-                }
-            }
+        Stencil::dispatch(grid, [&](const auto& view) {
+            for (int idx : order) {
+                if (!agents.occupied(idx)) continue;
+
+                CellRng rng = cellRng(idx, RngPhase::Movement);
+                if (rng.uniform() > moveProb) continue;
 
-            if (bestPos.first != x || bestPos.second != y) {
-                grid.get(bestPos.first, bestPos.second) = a;
-                grid.get(x, y) = nullptr;
+                int target = view.visit(idx, [&](int cell, const auto& nb) { return chooseMoveTarget(view, cell, nb); });
+                if (target != idx) {
+                    agents.move(idx, target);
+                }
             }
+        });
+    }
+    else {
+        // Propozycje liczone równolegle na zamrożonym stanie. Kilku chętnych na to samo
+        // puste pole: wygrywa największy klucz (losowy klucz << 32 | źródło), więc wynik
+        // nie zależy od kolejności wątków.
+        std::vector<int>& target = scratch.moveTarget;
+        std::vector<uint64_t>& claim = scratch.moveClaim;
+        std::fill(claim.begin(), claim.end(), 0);
+
+        Stencil::dispatch(grid, [&](const auto& view) {
+            auto propose = [&](int idx, const auto& nb) {
+                target[idx] = -1;
+                if (!agents.occupied(idx)) return;
+
+                CellRng rng = cellRng(idx, RngPhase::Movement);
+                if (rng.uniform() > moveProb) return;
+
+                int t = chooseMoveTarget(view, idx, nb);
+                if (t == idx) return;
+
+                target[idx] = t;
+                uint64_t key = ((uint64_t)rng.next() << 32) | (uint32_t)idx;
+                std::atomic_ref<uint64_t> slot(claim[t]);
+                uint64_t seen = slot.load(std::memory_order_relaxed);
+                while (seen < key && !slot.compare_exchange_weak(seen, key, std::memory_order_relaxed)) {}
+            };
+
+#pragma omp parallel for
+            for (int y = 0; y < grid.height; ++y) view.forRow(y, propose);
+        });
+
+        // Zwycięzcy przenoszą się; źródła i cele są parami rozłączne
+#pragma omp parallel for
+        for (int idx = 0; idx < cells; ++idx) {
+            int t = target[idx];
+            if (t < 0 || (uint32_t)claim[t] != (uint32_t)idx) continue;
+            agents.move(idx, t);
         }
     }
 
+    movementSpan.end();
+
     // =========================
     // FAZA 2: K RUND IPD + payoff średni
     // =========================
-    for (auto& up : agents) {
-        up->payoff = 0.0f; // kumulujemy w playOneRound()
-    }
+    PhaseSpan roundsSpan(timers, Phase::Rounds);
+    std::fill(agents.payoff.begin(), agents.payoff.end(), 0.0f); // kumulujemy w playOneRound()
 
     int K = std::max(1, roundsPerGeneration);
     for (int r = 0; r < K; ++r) {
@@ -244,399 +473,550 @@ void Simulation::step() {
     }
 
     // uśrednij payoff po K rundach
-    for (auto& up : agents) {
-        up->payoff /= (float)K;
+    for (int idx = 0; idx < cells; ++idx) {
+        agents.payoff[idx] /= (float)K;
     }
 
+    roundsSpan.end();
+
+    const int neighborsCount = grid.maxNeighbors();
+    PhaseSpan evolutionSpan(timers, Phase::Evolution);
+
     // =========================
     // FAZA 3: DEATH-BIRTH
     // =========================
     if (mode == EvolutionMode::DeathBirth) {
 
-        // 1) DEATH
-        for (int y = 0; y < grid.height; ++y) {
-            for (int x = 0; x < grid.width; ++x) {
-                Agent* a = grid.get(x, y);
-                if (!a) continue;
-
-                if (uni01(rng) < deathProb) {
-                    a->alive = false;
-                    grid.get(x, y) = nullptr;
-                    deadPool.push_back(a);
+        // 1) DEATH (każda komórka losuje ze swojego strumienia, więc kolejność nie ma znaczenia)
+#pragma omp parallel
+        {
+            PopulationCounts deaths; // zmiany liczników tego wątku
+#pragma omp for nowait
+            for (int idx = 0; idx < cells; ++idx) {
+                if (!agents.occupied(idx)) continue;
+
+                if (cellRng(idx, RngPhase::Death).uniform() < deathProb) {
+                    deaths.remove(agents.type[idx], agents.currentAction[idx]);
+                    agents.kill(idx);
                 }
             }
+#pragma omp critical(population)
+            population += deaths;
         }
 
         // 2) BIRTH
-        for (int y = 0; y < grid.height; ++y) {
-            for (int x = 0; x < grid.width; ++x) {
-                if (grid.get(x, y) != nullptr) continue;
-
-                if (uni01(rng) > reproductionProb) continue;
-
-                auto neigh = grid.getNeighborCoords(x, y);
-
-                std::vector<Agent*> parents;
-                parents.reserve(neigh.size());
-                for (auto [nx, ny] : neigh) {
-                    Agent* p = grid.get(nx, ny);
-                    if (p && p->alive) parents.push_back(p);
-                }
-                if (parents.empty()) continue;
-
-                float sumW = 0.0f;
-                std::vector<float> w;
-                w.reserve(parents.size());
-                for (auto* p : parents) {
-                    float wi = fitnessFromPayoff(p->payoff, selectionBeta);
-                    w.push_back(wi);
-                    sumW += wi;
-                }
-                if (sumW <= 0.0f) continue;
-
-                float rr = uni01(rng) * sumW;
-                int chosen = 0;
-                for (int i = 0; i < (int)w.size(); ++i) {
-                    rr -= w[i];
-                    if (rr <= 0.0f) { chosen = i; break; }
-                }
-
-                Agent* parent = parents[chosen];
-
-                Agent* child = nullptr;
-                if (!deadPool.empty()) {
-                    child = deadPool.back();
-                    deadPool.pop_back();
-                }
-                else {
-                    auto up = std::make_unique<Agent>();
-                    child = up.get();
-                    agents.push_back(std::move(up));
-                }
-
-                child->alive = true;
-                child->payoff = 0.0f;
-                child->lastPayoff = 0.0f;
-                child->strategyAge = 0;
-
-                // DZIEDZICZENIE: typ od rodzica
-                child->type = parent->type;
-
-                // dziecko zaczyna czysto
-                child->currentAction = Action::Cooperate;
-                child->lastAction = Action::Cooperate;
+        if (birthScheduling == UpdateScheduling::Serial) {
+            // Raster: dziecko urodzone wcześniej może już być rodzicem dla kolejnych pól
+            Stencil::dispatch(grid, [&](const auto& view) {
+                auto birth = [&](int idx, const auto& nb) {
+                    if (agents.occupied(idx)) return;
+
+                    AgentType childType;
+                    if (chooseNewborn(idx, nb, childType)) {
+                        agents.spawn(idx, childType, neighborsCount);
+                        population.add(childType, Action::Cooperate);
+                    }
+                };
 
-                int neighborsCount = (grid.neighborhood == NeighborhoodType::Moore) ? 8 : 4;
-                child->resetMemory(neighborsCount);
+                for (int y = 0; y < grid.height; ++y) view.forRow(y, birth);
+            });
+        }
+        else {
+            // Klasy kolorów po kolei, w klasie równolegle: żadna komórka klasy nie jest sąsiadem
+            // innej, więc wynik nie zależy od liczby wątków. ID nadajemy potem w kolejności rastrowej.
+            std::vector<uint8_t>& born = scratch.born;
+            std::fill(born.begin(), born.end(), 0);
+
+            Stencil::dispatch(grid, [&](const auto& view) {
+                auto birth = [&](int idx, const auto& nb) {
+                    if (agents.occupied(idx)) return;
+
+                    AgentType childType;
+                    if (chooseNewborn(idx, nb, childType)) {
+                        agents.spawnWithId(idx, childType, neighborsCount, -1);
+                        born[idx] = 1;
+                    }
+                };
 
-                // reputacja neutralna
-                child->reputation = 0.5f;
+                for (int c = 0; c < grid.colorCount(); ++c) {
+                    const int32_t* members = grid.colorCells(c);
+                    const int n = grid.colorSize(c);
 
-                // MUTACJA typu
-                if (mutationRate > 0.0f) {
-                    std::bernoulli_distribution mut(mutationRate);
-                    if (mut(rng)) {
-                        std::uniform_int_distribution<int> typeDist(0, (int)allowedTypes.size() - 1);
-                        child->type = allowedTypes[typeDist(rng)];
-                    }
+#pragma omp parallel for
+                    for (int i = 0; i < n; ++i) view.visit(members[i], birth);
                 }
+            });
 
-                grid.get(x, y) = child;
+            for (int idx = 0; idx < cells; ++idx) {
+                if (!born[idx]) continue;
+                agents.id[idx] = agents.nextId++;
+                population.add(agents.type[idx], Action::Cooperate);
             }
         }
 
-        // postarzenie ocalałych
-        for (auto& ag : agents) {
-            if (ag->alive) ag->strategyAge++;
+        // postarzenie ocalałych (i sumy cech do metryk, blokami)
+        const int blocks = (int)scratch.blockTraits.size();
+#pragma omp parallel for
+        for (int blk = 0; blk < blocks; ++blk) {
+            TraitSums traits;
+            const int end = std::min(cells, (blk + 1) * KERNEL_BLOCK);
+            for (int idx = blk * KERNEL_BLOCK; idx < end; ++idx) {
+                if (!agents.occupied(idx)) continue;
+                agents.strategyAge[idx]++;
+                traits.add(agents, idx);
+            }
+            scratch.blockTraits[blk] = traits;
         }
-
-        generation++;
-        recordMetrics();
-        exportMetricsRowIfNeeded();
-        return;
+        traitsCurrent = true;
     }
 
     // =========================
     // FAZA 4: IMITATION
     // =========================
-    if (mode == EvolutionMode::Imitation) {
+    else if (mode == EvolutionMode::Imitation) {
 
         // Bufor na nowe typy, żeby zmiany były synchroniczne 
         // (wszyscy podejmują decyzję na podstawie STAREGO stanu)
-        std::vector<AgentType> nextTypes(grid.width * grid.height);
-
-        for (int y = 0; y < grid.height; ++y) {
-            for (int x = 0; x < grid.width; ++x) {
-                Agent* a = grid.get(x, y);
-                int idx = y * grid.width + x;
-
-                // Jeśli puste pole, nic się nie dzieje (w Imitacji puste pozostaje puste)
-                if (!a) {
-                    // Musimy zapamiętać, że tu nic nie ma, choć wektor przechowuje typy.
-                    // Ale my aktualizujemy tylko żywych. 
-                    // Typ w nextTypes dla pustego pola jest nieistotny.
-                    continue;
-                }
-
-                // Domyślnie zostajemy przy swoim typie
-                nextTypes[idx] = a->type;
-
-                // 1. Znajdź sąsiada do porównania
-                auto neighs = grid.getNeighborCoords(x, y);
-                if (neighs.empty()) continue;
-
-                // Wybieramy losowego sąsiada (standard w Ewolucyjnej Teorii Gier)
-                std::uniform_int_distribution<int> dist(0, (int)neighs.size() - 1);
-                auto [nx, ny] = neighs[dist(rng)];
-                Agent* neighbor = grid.get(nx, ny);
-
-                // Jeśli wylosowaliśmy puste pole, nic nie robimy
-                if (!neighbor) continue;
-
-                // 2. Decyzja o zmianie (Reguła update'u)
-                bool shouldCopy = false;
+        std::vector<AgentType>& nextTypes = scratch.nextTypes;
+        std::vector<int>& partner = scratch.imitPartner;
+        std::vector<float>& arg = scratch.imitArg;
+        std::vector<float>& draw = scratch.imitDraw;
+
+        const bool fermi = (updateRule == UpdateRule::Fermi);
+        const float invK = 1.0f / fermiK;
+        const int allowedCount = (int)allowedTypes.size();
+
+        // A) Losowania i wybór sąsiada (każda komórka ma własny strumień, więc pętla jest równoległa).
+        //    partner = -1 oznacza, że decyzja już zapadła (brak sąsiada, mutacja, BestNeighbor).
+#pragma omp parallel for
+        for (int idx = 0; idx < cells; ++idx) {
+            partner[idx] = -1;
+            arg[idx] = 0.0f;
+
+            // Jeśli puste pole, nic się nie dzieje (w Imitacji puste pozostaje puste)
+            if (!agents.occupied(idx)) continue;
+
+            // Domyślnie zostajemy przy swoim typie
+            nextTypes[idx] = agents.type[idx];
+
+            // 1. Znajdź sąsiada do porównania
+            const int count = grid.neighborCount(idx);
+            if (count == 0) continue;
+
+            // Wybieramy losowego sąsiada (standard w Ewolucyjnej Teorii Gier)
+            CellRng rng = cellRng(idx, RngPhase::Imitation);
+            int neighbor = grid.neighborsOf(idx)[rng.below(count)];
+
+            // Jeśli wylosowaliśmy puste pole, nic nie robimy
+            if (!agents.occupied(neighbor)) continue;
+
+            // 2. Decyzja o zmianie (Reguła update'u)
+            if (fermi) {
+                // Reguła Fermiego (probabilistyczna), exp liczony hurtem w kroku B:
+                // P = 1 / (1 + exp((MyPayoff - TheirPayoff) / K))
+                arg[idx] = FastMath::clampExpArg((agents.payoff[idx] - agents.payoff[neighbor]) * invK); // Moje minus Jego
+                draw[idx] = rng.uniform();
+                partner[idx] = neighbor;
+            }
+            else if (agents.payoff[neighbor] > agents.payoff[idx]) {
+                // BestNeighbor: kopiuj tylko jeśli sąsiad ma więcej punktów
+                nextTypes[idx] = agents.type[neighbor];
+            }
 
-                if (updateRule == UpdateRule::BestNeighbor) {
-                    // Kopiuj tylko jeśli sąsiad ma więcej punktów
-                    if (neighbor->payoff > a->payoff) {
-                        shouldCopy = true;
-                    }
-                }
-                else if (updateRule == UpdateRule::Fermi) {
-                    // Reguła Fermiego (probabilistyczna)
-                    // P = 1 / (1 + exp((MyPayoff - TheirPayoff) / K))
-                    float diff = a->payoff - neighbor->payoff; // Moje minus Jego
-                    float prob = 1.0f / (1.0f + std::exp(diff / fermiK));
-
-                    if (uni01(rng) < prob) {
-                        shouldCopy = true;
-                    }
+            // 3. Mutacja (szansa na losową zmianę mimo wszystko)
+            if (mutationRate > 0.0f) {
+                if (rng.uniform() < mutationRate) {
+                    nextTypes[idx] = allowedTypes[rng.below(allowedCount)];
+                    partner[idx] = -1; // mutacja wygrywa z kopiowaniem
                 }
+            }
+        }
 
-                if (shouldCopy) {
-                    nextTypes[idx] = neighbor->type;
-                }
+        if (fermi) {
+            // B) Prawdopodobieństwa Fermiego dla całej planszy naraz (wektorowy exp).
+            //    MSVC ma tylko OpenMP 2.0 bez `simd` - tam zostaje autowektoryzacja.
+#if defined(_OPENMP) && _OPENMP >= 201307
+#pragma omp parallel for simd
+#else
+#pragma omp parallel for
+#endif
+            for (int idx = 0; idx < cells; ++idx) {
+                arg[idx] = 1.0f / (1.0f + FastMath::expApprox(arg[idx]));
+            }
 
-                // 3. Mutacja (szansa na losową zmianę mimo wszystko)
-                if (mutationRate > 0.0f) {
-                    if (uni01(rng) < mutationRate) {
-                        std::uniform_int_distribution<int> typeDist(0, (int)allowedTypes.size() - 1);
-                        nextTypes[idx] = allowedTypes[typeDist(rng)];
-                    }
+            // C) Rozstrzygnięcie kopiowania
+#pragma omp parallel for
+            for (int idx = 0; idx < cells; ++idx) {
+                const int neighbor = partner[idx];
+                if (neighbor >= 0 && draw[idx] < arg[idx]) {
+                    nextTypes[idx] = agents.type[neighbor];
                 }
             }
         }
 
-        // Aplikujemy zmiany
-        for (int y = 0; y < grid.height; ++y) {
-            for (int x = 0; x < grid.width; ++x) {
-                Agent* a = grid.get(x, y);
-                if (a) {
-                    int idx = y * grid.width + x;
-                    // Resetujemy parametry przy zmianie strategii
-                    if (a->type != nextTypes[idx]) {
-                        a->type = nextTypes[idx];
-                        a->strategyAge = 0;
-                        a->currentAction = Action::Cooperate; // Reset zachowania
-
-                        int neighborsCount = (grid.neighborhood == NeighborhoodType::Moore) ? 8 : 4;
-                        a->resetMemory(neighborsCount);
+        // Aplikujemy zmiany (każda komórka zmienia tylko swój stan), blokami z sumami cech do metryk
+        const int blocks = (int)scratch.blockTraits.size();
+#pragma omp parallel
+        {
+            PopulationCounts changes; // zmiany liczników tego wątku
+#pragma omp for nowait
+            for (int blk = 0; blk < blocks; ++blk) {
+                TraitSums traits;
+                const int end = std::min(cells, (blk + 1) * KERNEL_BLOCK);
+                for (int idx = blk * KERNEL_BLOCK; idx < end; ++idx) {
+                    if (!agents.occupied(idx)) continue;
 
-                        a->reputation = 0.5f; // Nowa tożsamość = nowa reputacja
+                    // Resetujemy parametry przy zmianie strategii
+                    if (agents.type[idx] != nextTypes[idx]) {
+                        changes.remove(agents.type[idx], agents.currentAction[idx]);
+                        changes.add(nextTypes[idx], Action::Cooperate);
+
+                        agents.type[idx] = nextTypes[idx];
+                        agents.strategyAge[idx] = 0;
+                        agents.currentAction[idx] = Action::Cooperate; // Reset zachowania
+                        agents.resetMemory(idx, neighborsCount);
+                        agents.reputation[idx] = 0.5f; // Nowa tożsamość = nowa reputacja
+                        agents.markChanged(idx);
                     }
                     else {
-                        a->strategyAge++;
+                        agents.strategyAge[idx]++;
                     }
+                    traits.add(agents, idx);
                 }
+                scratch.blockTraits[blk] = traits;
             }
+#pragma omp critical(population)
+            population += changes;
         }
+        traitsCurrent = true;
     }
 
 
+    evolutionSpan.end();
+
     generation++;
+
+    PhaseSpan metricsSpan(timers, Phase::Metrics);
     recordMetrics();
+    metricsSpan.end();
+
+    assert(AllocationCounter::teamCount() == allocationsBefore && "step() alokował w stanie ustalonym");
+
+    // Eksport na końcu, po sprawdzeniu alokacji: może otworzyć plik, zapisać nagłówek i powiększyć
+    // bufor wątku zapisu. Osobna faza: wiersz niesie czasy obliczeń tego pokolenia, a czas
+    // samego eksportu trafia do wiersza następnego
+    PhaseSpan exportSpan(timers, Phase::Export);
     exportMetricsRowIfNeeded();
+    exportSpan.end();
+
+    timers.endGeneration();
 }
 
 float Simulation::cooperationRate() const {
-    int c = 0;
-    int alive = 0;
-    for (int y = 0; y < grid.height; ++y) {
-        for (int x = 0; x < grid.width; ++x) {
-            const Agent* a = grid.get(x, y);
-            if (!a) continue;
-            alive++;
-            if (a->currentAction == Action::Cooperate) c++;
+    return (population.alive > 0) ? (float)population.coop / (float)population.alive : 0.0f;
+}
+
+PopulationCounts Simulation::countPopulation() const {
+    PopulationCounts counts;
+    for (int idx = 0; idx < agents.size(); ++idx) {
+        if (agents.occupied(idx)) counts.add(agents.type[idx], agents.currentAction[idx]);
+    }
+    return counts;
+}
+
+void Simulation::recountPopulation() {
+    population = countPopulation();
+    traitsCurrent = false;
+}
+
+void Simulation::sumTraits() {
+    prepareScratch(); // siatka mogła się zmienić od ostatniego pokolenia (wczytany stan)
+    const int cells = agents.size();
+    const int blocks = (int)scratch.blockTraits.size();
+
+#pragma omp parallel for
+    for (int blk = 0; blk < blocks; ++blk) {
+        TraitSums traits;
+        const int end = std::min(cells, (blk + 1) * KERNEL_BLOCK);
+        for (int idx = blk * KERNEL_BLOCK; idx < end; ++idx) {
+            if (agents.occupied(idx)) traits.add(agents, idx);
         }
+        scratch.blockTraits[blk] = traits;
     }
-    return (alive > 0) ? (float)c / (float)alive : 0.0f;
+    traitsCurrent = true;
 }
 
 void Simulation::recordMetrics() {
-    MetricsSample m;
-    m.generation = generation;
-
-    int alive = 0, empty = 0;
-    int coop = 0, defect = 0;
-
-    // Liczniki dla średnich (Liczba i Suma)
-    int cAC = 0, cAD = 0, cT = 0, cP = 0, cDisc = 0;
-
-    // Payoff sumy
-    double sumPayAC = 0, sumPayAD = 0, sumPayT = 0, sumPayP = 0, sumPayDisc = 0;
-
-    // Reputacja sumy (NOWOŚĆ)
-    double sumRepAC = 0, sumRepAD = 0, sumRepT = 0, sumRepP = 0, sumRepDisc = 0;
-
-    double globalSumRep = 0.0;
-    double globalSumAge = 0.0; // Do średniego wieku
-
-    for (int y = 0; y < grid.height; ++y) {
-        for (int x = 0; x < grid.width; ++x) {
-            Agent* a = grid.get(x, y);
-            if (!a) { empty++; continue; }
-
-            alive++;
-            globalSumRep += a->reputation;
-            globalSumAge += a->strategyAge; // Sumujemy wiek
-
-            if (a->currentAction == Action::Cooperate) coop++;
-            else defect++;
-
-            switch (a->type) {
-            case AgentType::AlwaysCooperate:
-                cAC++;
-                sumPayAC += a->payoff;
-                sumRepAC += a->reputation;
-                break;
-            case AgentType::AlwaysDefect:
-                cAD++;
-                sumPayAD += a->payoff;
-                sumRepAD += a->reputation;
-                break;
-            case AgentType::TitForTat:
-                cT++;
-                sumPayT += a->payoff;
-                sumRepT += a->reputation;
-                break;
-            case AgentType::Pavlov:
-                cP++;
-                sumPayP += a->payoff;
-                sumRepP += a->reputation;
-                break;
-            case AgentType::Discriminator:
-                cDisc++;
-                sumPayDisc += a->payoff;
-                sumRepDisc += a->reputation;
-                break;
-            }
+    // Liczniki są aktualne zawsze; sumy cech policzyło ostatnie przejście ewolucji
+    // (po reset() albo wczytaniu stanu liczymy je tutaj)
+    assert(population == countPopulation() && "liczniki populacji rozjechały się ze stanem");
+    if (!traitsCurrent) sumTraits();
+
+    TraitSums total;
+    for (const TraitSums& b : scratch.blockTraits) {
+        for (int t = 0; t < AGENT_TYPE_COUNT; ++t) {
+            total.payoff[t] += b.payoff[t];
+            total.reputation[t] += b.reputation[t];
         }
+        total.reputationAll += b.reputationAll;
+        total.strategyAge += b.strategyAge;
     }
 
+    const int alive = population.alive;
+    const int* count = population.perType;
+    auto average = [](double sum, int n) { return (n > 0) ? (float)(sum / (double)n) : 0.0f; };
+
+    MetricsSample m;
+    m.generation = generation;
+
     // Podstawowe
     m.alive = alive;
-    m.empty = empty;
-    m.coop = coop;
-    m.defect = defect;
-    m.coopRatio = (alive > 0) ? (float)coop / (float)alive : 0.0f;
+    m.empty = agents.size() - alive;
+    m.coop = population.coop;
+    m.defect = alive - population.coop;
+    m.coopRatio = cooperationRate();
 
     // Globalne średnie
-    m.avgReputation = (alive > 0) ? (float)(globalSumRep / (double)alive) : 0.0f;
-    m.avgStrategyAge = (alive > 0) ? (float)(globalSumAge / (double)alive) : 0.0f;
+    m.avgReputation = average(total.reputationAll, alive);
+    m.avgStrategyAge = average(total.strategyAge, alive);
 
     // Liczebności
-    m.countAlwaysC = cAC;
-    m.countAlwaysD = cAD;
-    m.countTitForTat = cT;
-    m.countPavlov = cP;
-    m.countDiscriminator = cDisc;
+    const int AC = (int)AgentType::AlwaysCooperate, AD = (int)AgentType::AlwaysDefect;
+    const int TFT = (int)AgentType::TitForTat, PAV = (int)AgentType::Pavlov, DISC = (int)AgentType::Discriminator;
+    m.countAlwaysC = count[AC];
+    m.countAlwaysD = count[AD];
+    m.countTitForTat = count[TFT];
+    m.countPavlov = count[PAV];
+    m.countDiscriminator = count[DISC];
 
     // Średnie Payoff
-    m.avgPayoffAlwaysC = (cAC > 0) ? (float)(sumPayAC / cAC) : 0.0f;
-    m.avgPayoffAlwaysD = (cAD > 0) ? (float)(sumPayAD / cAD) : 0.0f;
-    m.avgPayoffTFT = (cT > 0) ? (float)(sumPayT / cT) : 0.0f;
-    m.avgPayoffPavlov = (cP > 0) ? (float)(sumPayP / cP) : 0.0f;
-    m.avgPayoffDiscriminator = (cDisc > 0) ? (float)(sumPayDisc / cDisc) : 0.0f;
-
-    // Średnie Reputacje (NOWOŚĆ)
-    m.avgRepAlwaysC = (cAC > 0) ? (float)(sumRepAC / cAC) : 0.0f;
-    m.avgRepAlwaysD = (cAD > 0) ? (float)(sumRepAD / cAD) : 0.0f;
-    m.avgRepTFT = (cT > 0) ? (float)(sumRepT / cT) : 0.0f;
-    m.avgRepPavlov = (cP > 0) ? (float)(sumRepP / cP) : 0.0f;
-    m.avgRepDiscriminator = (cDisc > 0) ? (float)(sumRepDisc / cDisc) : 0.0f;
+    m.avgPayoffAlwaysC = average(total.payoff[AC], count[AC]);
+    m.avgPayoffAlwaysD = average(total.payoff[AD], count[AD]);
+    m.avgPayoffTFT = average(total.payoff[TFT], count[TFT]);
+    m.avgPayoffPavlov = average(total.payoff[PAV], count[PAV]);
+    m.avgPayoffDiscriminator = average(total.payoff[DISC], count[DISC]);
+
+    // Średnie Reputacje
+    m.avgRepAlwaysC = average(total.reputation[AC], count[AC]);
+    m.avgRepAlwaysD = average(total.reputation[AD], count[AD]);
+    m.avgRepTFT = average(total.reputation[TFT], count[TFT]);
+    m.avgRepPavlov = average(total.reputation[PAV], count[PAV]);
+    m.avgRepDiscriminator = average(total.reputation[DISC], count[DISC]);
 
     lastMetrics = m;
+    if (history.capacity() != historyMax) history.setCapacity(historyMax);
     history.push_back(m);
-    while (history.size() > historyMax) history.pop_front();
+}
+
+void writeMetricsCsvHeader(std::ostream& f) {
+    f << "Generation,Alive,Empty,Coop,Defect,CoopRatio,AvgReputation,AvgStrategyAge,"
+        << "Count_AC,Count_AD,Count_TFT,Count_Pavlov,Count_Disc,"
+        << "Payoff_AC,Payoff_AD,Payoff_TFT,Payoff_Pavlov,Payoff_Disc,"
+        << "Rep_AC,Rep_AD,Rep_TFT,Rep_Pavlov,Rep_Disc";
+}
+
+namespace {
+    // Nagłówek eksportu CSV z kolumnami czasów faz albo bez nich, z końcem wiersza
+    std::string metricsCsvHeaderLine(bool timingColumns) {
+        std::ostringstream header;
+        writeMetricsCsvHeader(header);
+        if (timingColumns) {
+            for (size_t p = 0; p < PHASE_COUNT; ++p) {
+                // Eksport tego pokolenia jeszcze trwa, więc kolumna dotyczy poprzedniego
+                header << ",Time_" << phaseName((Phase)p) << ((Phase)p == Phase::Export ? "Prev" : "");
+            }
+        }
+        header << "\n";
+        return header.str();
+    }
+
+    // Jak operator<< z domyślną precyzją strumienia (6 cyfr znaczących), więc pliki się nie zmieniają
+    char* appendNumber(char* out, int v) {
+        return std::to_chars(out, out + 16, v).ptr;
+    }
+
+    char* appendNumber(char* out, double v) {
+        return std::to_chars(out, out + 32, v, std::chars_format::general, 6).ptr;
+    }
+}
+
+char* formatMetricsCsvRow(char* out, const MetricsSample& m) {
+    const int ints[] = { m.generation, m.alive, m.empty, m.coop, m.defect };
+    const float floats[] = { m.coopRatio, m.avgReputation, m.avgStrategyAge };
+    const int counts[] = { m.countAlwaysC, m.countAlwaysD, m.countTitForTat, m.countPavlov, m.countDiscriminator };
+    const float perType[] = {
+        // Payoffs
+        m.avgPayoffAlwaysC, m.avgPayoffAlwaysD, m.avgPayoffTFT, m.avgPayoffPavlov, m.avgPayoffDiscriminator,
+        // Reputations
+        m.avgRepAlwaysC, m.avgRepAlwaysD, m.avgRepTFT, m.avgRepPavlov, m.avgRepDiscriminator
+    };
+
+    for (int v : ints) { out = appendNumber(out, v); *out++ = ','; }
+    for (float v : floats) { out = appendNumber(out, (double)v); *out++ = ','; }
+    for (int v : counts) { out = appendNumber(out, v); *out++ = ','; }
+    for (float v : perType) { out = appendNumber(out, (double)v); *out++ = ','; }
+
+    return out - 1; // bez przecinka po ostatniej kolumnie
+}
+
+void writeMetricsCsvRow(std::ostream& f, const MetricsSample& m) {
+    char row[METRICS_CSV_ROW_MAX];
+    f.write(row, formatMetricsCsvRow(row, m) - row);
 }
 
 void Simulation::exportMetricsRowIfNeeded() {
-    if (!exportCsvEnabled) return;
+    if (!exportCsvEnabled) {
+        // Wyłączony zapis: dopisujemy resztę i zwalniamy plik (GUI może go teraz otworzyć gdzie indziej)
+        closeMetricsFile();
+        return;
+    }
 
-    std::ofstream f(exportPath, std::ios::app);
-    if (!f) return;
+    if (!metricsSink.isOpen() || metricsSink.path() != exportPath) {
+        closeMetricsFile();
+        if (!metricsSink.open(exportPath, false)) return;
+    }
+
+    // Jeśli nagłówek nie został zapisany, tworzymy go (z nowymi kolumnami).
+    // Kolumny czasów ustalamy razem z nagłówkiem, żeby plik miał stały układ.
+    if (!csvHeaderWritten) {
+        csvTimingColumns = exportTimings && PhaseTimers::enabled;
+    }
+
+    if (exportFormat == MetricsFormat::Binary) {
+        if (!logStarted) {
+            MetricsLog::Header header;
+            header.columns = MetricsLog::metricsColumns(csvTimingColumns);
+            header.params = SimulationConfig::currentValues(*this);
+            header.compressed = exportCompression;
+            logEncoder.begin(header);
+            logStarted = true;
+
+            // Każda sesja zapisu (nowy plik, reset, wznowienie) zaczyna własny segment, więc blok
+            // nigdy nie trafia pod nagłówek z innym układem kolumn albo innymi parametrami
+            logBytes.clear();
+            logEncoder.writeHeader(logBytes);
+            metricsSink.append(logBytes);
+        }
+        csvHeaderWritten = true;
+
+        uint64_t row[MetricsLog::METRICS_COLUMNS + PHASE_COUNT];
+        MetricsLog::metricsRow(lastMetrics, row);
+        if (csvTimingColumns) {
+            for (size_t p = 0; p < PHASE_COUNT; ++p) {
+                const PhaseTimes& t = ((Phase)p == Phase::Export) ? timers.last() : timers.inProgress();
+                row[MetricsLog::METRICS_COLUMNS + p] = MetricsLog::bitsOf(t.ms[p]);
+            }
+        }
+        logEncoder.push(row);
+
+        // Pełny blok albo blok czekający dłużej niż próg zapisu (żeby log dało się czytać w trakcie)
+        if (logEncoder.blockFull() || logEncoder.pendingAge() >= MetricsWriter::DEFAULT_FLUSH_INTERVAL) emitLogBlock();
+        return;
+    }
 
-    // Jeśli nagłówek nie został zapisany, tworzymy go (z nowymi kolumnami)
     if (!csvHeaderWritten) {
-        f << "Generation,Alive,Empty,Coop,Defect,CoopRatio,AvgReputation,AvgStrategyAge,"
-            << "Count_AC,Count_AD,Count_TFT,Count_Pavlov,Count_Disc,"
-            << "Payoff_AC,Payoff_AD,Payoff_TFT,Payoff_Pavlov,Payoff_Disc,"
-            << "Rep_AC,Rep_AD,Rep_TFT,Rep_Pavlov,Rep_Disc\n";
+        metricsSink.append(metricsCsvHeaderLine(csvTimingColumns));
         csvHeaderWritten = true;
     }
 
-    const auto& m = lastMetrics;
-    f << m.generation << ","
-        << m.alive << ","
-        << m.empty << ","
-        << m.coop << ","
-        << m.defect << ","
-        << m.coopRatio << ","
-        << m.avgReputation << ","
-        << m.avgStrategyAge << ","
-
-        // Counts
-        << m.countAlwaysC << ","
-        << m.countAlwaysD << ","
-        << m.countTitForTat << ","
-        << m.countPavlov << ","
-        << m.countDiscriminator << ","
+    // Wiersz + do PHASE_COUNT kolumn czasów, składany na stosie
+    char row[METRICS_CSV_ROW_MAX + PHASE_COUNT * 32 + 1];
+    char* end = formatMetricsCsvRow(row, lastMetrics);
+    if (csvTimingColumns) {
+        for (size_t p = 0; p < PHASE_COUNT; ++p) {
+            const PhaseTimes& t = ((Phase)p == Phase::Export) ? timers.last() : timers.inProgress();
+            *end++ = ',';
+            end = appendNumber(end, t.ms[p]);
+        }
+    }
+    *end++ = '\n';
+    metricsSink.append(row, (size_t)(end - row));
+}
 
-        // Payoffs
-        << m.avgPayoffAlwaysC << ","
-        << m.avgPayoffAlwaysD << ","
-        << m.avgPayoffTFT << ","
-        << m.avgPayoffPavlov << ","
-        << m.avgPayoffDiscriminator << ","
+void Simulation::emitLogBlock() {
+    if (!logStarted || logEncoder.pendingRows() == 0) return;
 
-        // Reputations
-        << m.avgRepAlwaysC << ","
-        << m.avgRepAlwaysD << ","
-        << m.avgRepTFT << ","
-        << m.avgRepPavlov << ","
-        << m.avgRepDiscriminator
-        << "\n";
+    logBytes.clear();
+    logEncoder.encodeBlock(logBytes);
+    metricsSink.append(logBytes);
+}
+
+void Simulation::closeMetricsFile() {
+    emitLogBlock();
+    metricsSink.close();
 }
 
 void Simulation::newCsvFile() {
-    std::ofstream f(exportPath, std::ios::trunc); // trunc usuwa zawartość
-    if (f.is_open()) {
-        csvHeaderWritten = false; // Wymuszenie ponownego zapisu nagłówka
-        f.close();
+    // Wiersze starego pliku trafiają jeszcze do niego; nowy otwieramy od zera
+    closeMetricsFile();
+    metricsSink.open(exportPath, true);
+    csvHeaderWritten = false; // Wymuszenie ponownego zapisu nagłówka
+    logStarted = false;
+
+    // Bez włączonego zapisu nie trzymamy pliku otwartego
+    if (!exportCsvEnabled) metricsSink.close();
+}
+
+bool Simulation::continueCsvFile(std::string& error) {
+    closeMetricsFile(); // rozmiar pliku po zapisaniu buforów
+
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(exportPath, ec);
+
+    csvHeaderWritten = !ec && size > 0;
+    csvTimingColumns = exportTimings && PhaseTimers::enabled;
+    logStarted = false;
+    if (!csvHeaderWritten) return true;
+
+    // Plik mógł dojść dalej niż punkt kontrolny (zapis przed awarią); te pokolenia policzymy
+    // jeszcze raz, więc je obcinamy, żeby nie było ich w pliku dwa razy
+    if (exportFormat == MetricsFormat::Binary) return MetricsLog::truncateAfter(exportPath, generation, error);
+
+    std::ifstream in(exportPath, std::ios::binary);
+    std::string line;
+    if (!std::getline(in, line) || line + "\n" != metricsCsvHeaderLine(csvTimingColumns)) {
+        error = "'" + exportPath + "' ma inny nagłówek niż bieżący eksport CSV (export_timings, export_format?)";
+        return false;
+    }
+
+    // Tylko pełne wiersze (z końcem linii); urwany ostatni wiersz też odpada
+    uint64_t keepBytes = (uint64_t)in.tellg();
+    uint64_t pos = keepBytes;
+    while (std::getline(in, line)) {
+        if (in.eof()) break;
+        pos += line.size() + 1;
+        int rowGeneration = 0;
+        const auto res = std::from_chars(line.data(), line.data() + line.size(), rowGeneration);
+        if (res.ec == std::errc() && rowGeneration <= generation) keepBytes = pos;
+    }
+    in.close();
+
+    std::filesystem::resize_file(exportPath, keepBytes, ec);
+    if (ec) {
+        error = "nie można obciąć '" + exportPath + "': " + ec.message();
+        return false;
     }
+    return true;
 }
 
-void Simulation::reset() {
-    Agent::nextId = 0; // Resetujemy licznik ID, żeby nie rósł w nieskończoność
+bool Simulation::flushCsvFile() {
+    emitLogBlock();
+    return metricsSink.flush();
+}
 
-    // 1. Czyścimy wszystko
-    agents.clear();      // Usuwa obiekty agentów (unique_ptr)
-    grid.clear();        // Zeruje wskaźniki na siatce
-    deadPool.clear();    // Czyści pulę martwych
+void Simulation::reset() {
+    // 1. Czyścimy wszystko (także licznik ID, żeby nie rósł w nieskończoność)
+    agents.resize(grid.cellCount());
+    grid.updateTopology();
+    prepareScratch();
     history.clear();     // Czyści wykresy
 
     generation = 0;
+    population = PopulationCounts{};
+    traitsCurrent = false;
     csvHeaderWritten = false; // Żeby nowy plik CSV miał nagłówek
+    emitLogBlock();           // blok starej populacji jeszcze do starego nagłówka
+    logStarted = false;
 
     // 2. Aktualizujemy listę dozwolonych typów (na podstawie flag z GUI)
     allowedTypes.clear();
@@ -650,27 +1030,17 @@ void Simulation::reset() {
     if (allowedTypes.empty()) allowedTypes.push_back(AgentType::AlwaysCooperate);
 
     // 3. Rozmieszczamy agentów (tak jak wcześniej w konstruktorze)
-    std::bernoulli_distribution place(density);
+    const int neighborsCount = grid.maxNeighbors();
 
-    for (int y = 0; y < grid.height; ++y) {
-        for (int x = 0; x < grid.width; ++x) {
-            if (!place(rng)) continue;
+    for (int idx = 0; idx < grid.cellCount(); ++idx) {
+        CellRng rng = cellRng(idx, RngPhase::Placement);
+        if (rng.uniform() >= density) continue;
 
-            // Losujemy typ z allowedTypes
-            std::uniform_int_distribution<int> typeDist(0, (int)allowedTypes.size() - 1);
-            AgentType t = allowedTypes[typeDist(rng)];
+        // Losujemy typ z allowedTypes
+        AgentType t = allowedTypes[rng.below((int)allowedTypes.size())];
 
-            auto a = std::make_unique<Agent>(t);
-            a->payoff = 0.0f;
-            a->lastPayoff = 0.0f;
-            a->reputation = 0.5f;
-
-            int neighborsCount = (grid.neighborhood == NeighborhoodType::Moore) ? 8 : 4;
-            a->resetMemory(neighborsCount);
-
-            grid.get(x, y) = a.get();
-            agents.push_back(std::move(a));
-        }
+        agents.spawn(idx, t, neighborsCount);
+        population.add(t, Action::Cooperate);
     }
 
     // 4. Zapisz stan początkowy (generacja 0)
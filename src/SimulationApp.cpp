@@ -1,12 +1,13 @@
 ﻿#include "SimulationApp.hpp"
+#include "Trace.hpp"
 
 SimulationApp::SimulationApp()
     : window(sf::VideoMode({ WINDOW_WIDTH, WINDOW_HEIGHT }), "Ewolucja zachowan spolecznych",
         sf::Style::Titlebar | sf::Style::Close),
     sim(GRID_WIDTH, GRID_HEIGHT, { 3, 4, 0, 0.1 }),
-    renderer(sim),
-    gui(sim, running),
-    leftPanel(sim, renderer)
+    controller(sim),
+    leftPanel(renderer),
+    gui(controller)
 {
     window.setFramerateLimit(60);
     ImGui::SFML::Init(window);
@@ -50,25 +51,46 @@ SimulationApp::~SimulationApp() {
 }
 
 void SimulationApp::run() {
+    Trace::setThreadName("UI");
 
     while (window.isOpen()) {
-
-        while (const std::optional event = window.pollEvent()) {
-            ImGui::SFML::ProcessEvent(window, *event);
-            if (event->is<sf::Event::Closed>())
-                window.close();
+        // Klatka w śladzie. Pokolenia liczy wątek "Symulacja"; tylko w trybie inline
+        // step() trafia do wątku UI i jego czas to przestój interfejsu.
+        Trace::Scope frameTrace("Frame");
+
+        {
+            Trace::Scope trace("Events");
+            while (const std::optional event = window.pollEvent()) {
+                ImGui::SFML::ProcessEvent(window, *event);
+                if (event->is<sf::Event::Closed>())
+                    window.close();
+            }
         }
 
-        ImGui::SFML::Update(window, deltaClock.restart());
+        controller.frame();
+
+        // Stan z końca ostatniego pokolenia; silnik w tym czasie pisze do drugiego bufora
+        const SimulationSnapshot& snap = controller.acquire();
+
+        {
+            Trace::Scope trace("Gui");
+            ImGui::SFML::Update(window, deltaClock.restart());
 
-        gui.update(window, leftMode);
-        leftPanel.setMode(leftMode);
+            gui.update(window, leftMode, snap);
+            leftPanel.setMode(leftMode);
+        }
+
+        {
+            Trace::Scope trace("Render");
+            window.clear();
+            leftPanel.draw(snap);
+            ImGui::SFML::Render(window);
+        }
 
-        if (running) sim.step();
+        controller.release();
 
-        window.clear();
-        leftPanel.draw();
-        ImGui::SFML::Render(window);
+        // display() czeka na limit klatek, więc osobno od rysowania
+        Trace::Scope trace("Display");
         window.display();
     }
 }
@@ -0,0 +1,305 @@
+#include "SimulationConfig.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+
+namespace {
+
+    std::string trim(const std::string& s) {
+        size_t b = 0, e = s.size();
+        while (b < e && std::isspace((unsigned char)s[b])) b++;
+        while (e > b && std::isspace((unsigned char)s[e - 1])) e--;
+        return s.substr(b, e - b);
+    }
+
+    std::string lower(std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+        return s;
+    }
+
+    template <class T>
+    bool parseNumber(const std::string& text, T& out) {
+        const char* end = text.data() + text.size();
+        auto res = std::from_chars(text.data(), end, out);
+        return res.ec == std::errc() && res.ptr == end;
+    }
+
+    bool parseBool(const std::string& text, bool& out) {
+        std::string v = lower(text);
+        if (v == "1" || v == "true" || v == "on" || v == "yes") { out = true; return true; }
+        if (v == "0" || v == "false" || v == "off" || v == "no") { out = false; return true; }
+        return false;
+    }
+
+    template <class E>
+    using EnumNames = std::initializer_list<std::pair<const char*, E>>;
+
+    const EnumNames<BoundaryMode> boundaryNames = { { "periodic", BoundaryMode::Periodic }, { "fixed", BoundaryMode::Fixed },
+        { "reflective", BoundaryMode::Reflective }, { "absorbing", BoundaryMode::Absorbing } };
+    const EnumNames<NeighborhoodType> neighborhoodNames = { { "moore", NeighborhoodType::Moore }, { "vonneumann", NeighborhoodType::VonNeumann } };
+    const EnumNames<EvolutionMode> modeNames = { { "imitation", EvolutionMode::Imitation }, { "deathbirth", EvolutionMode::DeathBirth } };
+    const EnumNames<UpdateRule> ruleNames = { { "bestneighbor", UpdateRule::BestNeighbor }, { "fermi", UpdateRule::Fermi } };
+    const EnumNames<MetricsFormat> formatNames = { { "csv", MetricsFormat::Csv }, { "binary", MetricsFormat::Binary } };
+    const EnumNames<UpdateScheduling> schedulingNames = { { "serial", UpdateScheduling::Serial }, { "parallel", UpdateScheduling::Parallel } };
+
+    // Wartość enuma po nazwie (bez rozróżniania wielkości liter)
+    template <class E>
+    bool parseEnum(const std::string& text, EnumNames<E> names, E& out) {
+        std::string v = lower(text);
+        for (const auto& [name, value] : names) {
+            if (v == name) { out = value; return true; }
+        }
+        return false;
+    }
+
+    template <class E>
+    std::string formatEnum(EnumNames<E> names, E value) {
+        for (const auto& [name, v] : names) {
+            if (v == value) return name;
+        }
+        return "?";
+    }
+
+    // Najkrótszy zapis, który czyta się z powrotem do tej samej wartości
+    template <class T>
+    std::string formatNumber(T value) {
+        char buf[32];
+        return std::string(buf, std::to_chars(buf, buf + sizeof(buf), value).ptr);
+    }
+
+    std::string formatBool(bool value) {
+        return value ? "true" : "false";
+    }
+
+    std::string formatStrategies(const Simulation& sim) {
+        std::string out;
+        auto add = [&](bool on, const char* name) {
+            if (!on) return;
+            if (!out.empty()) out += ",";
+            out += name;
+        };
+        add(sim.useAlwaysCooperate, "allc");
+        add(sim.useAlwaysDefect, "alld");
+        add(sim.useTitForTat, "tft");
+        add(sim.usePavlov, "pavlov");
+        add(sim.useDiscriminator, "disc");
+        return out;
+    }
+
+    // Lista strategii po przecinku, np. "allc,tft,pavlov"
+    bool parseStrategies(Simulation& sim, const std::string& text) {
+        bool ac = false, ad = false, tft = false, pav = false, disc = false;
+        size_t pos = 0;
+        while (pos <= text.size()) {
+            size_t comma = text.find(',', pos);
+            if (comma == std::string::npos) comma = text.size();
+            std::string name = lower(trim(text.substr(pos, comma - pos)));
+            if (name == "allc") ac = true;
+            else if (name == "alld") ad = true;
+            else if (name == "tft") tft = true;
+            else if (name == "pavlov") pav = true;
+            else if (name == "disc") disc = true;
+            else if (!name.empty()) return false;
+            pos = comma + 1;
+        }
+        sim.useAlwaysCooperate = ac;
+        sim.useAlwaysDefect = ad;
+        sim.useTitForTat = tft;
+        sim.usePavlov = pav;
+        sim.useDiscriminator = disc;
+        return true;
+    }
+
+    struct Setting {
+        const char* key;
+        const char* help;
+        std::function<bool(Simulation&, const std::string&)> set;
+        std::function<std::string(const Simulation&)> get;
+    };
+
+    bool setInt(int& field, const std::string& v, int minValue) {
+        int x;
+        if (!parseNumber(v, x) || x < minValue) return false;
+        field = x;
+        return true;
+    }
+
+    bool setFloat(float& field, const std::string& v) {
+        return parseNumber(v, field);
+    }
+
+    // Wymiar siatki: iloczyn liczony w 64 bitach, z tą samą granicą co przy wczytaniu punktu
+    // kontrolnego (indeksy pamięci partnerów, komórka × MaxNeighbors, muszą zmieścić się w int)
+    bool setDimension(int& field, const std::string& v, int other) {
+        int x;
+        if (!parseNumber(v, x) || x < 1 || (int64_t)x * other > (int64_t)INT32_MAX / AgentStore::MaxNeighbors) return false;
+        field = x;
+        return true;
+    }
+
+    // Prawdopodobieństwo z [0, 1]; NaN też odpada
+    bool setProbability(float& field, const std::string& v) {
+        float x;
+        if (!parseNumber(v, x) || !(x >= 0.0f && x <= 1.0f)) return false;
+        field = x;
+        return true;
+    }
+
+    const std::vector<Setting>& settings() {
+        static const std::vector<Setting> table = {
+            { "width", "szerokość siatki (szerokość × wysokość < 2^28)",
+                [](Simulation& s, const std::string& v) { return setDimension(s.grid.width, v, s.grid.height); },
+                [](const Simulation& s) { return formatNumber(s.grid.width); } },
+            { "height", "wysokość siatki (szerokość × wysokość < 2^28)",
+                [](Simulation& s, const std::string& v) { return setDimension(s.grid.height, v, s.grid.width); },
+                [](const Simulation& s) { return formatNumber(s.grid.height); } },
+            { "boundary", "periodic | fixed | reflective | absorbing",
+                [](Simulation& s, const std::string& v) { return parseEnum(v, boundaryNames, s.grid.boundary); },
+                [](const Simulation& s) { return formatEnum(boundaryNames, s.grid.boundary); } },
+            { "neighborhood", "moore | vonneumann",
+                [](Simulation& s, const std::string& v) { return parseEnum(v, neighborhoodNames, s.grid.neighborhood); },
+                [](const Simulation& s) { return formatEnum(neighborhoodNames, s.grid.neighborhood); } },
+            { "R", "nagroda za obustronną współpracę",
+                [](Simulation& s, const std::string& v) { return setFloat(s.matrix.R, v); },
+                [](const Simulation& s) { return formatNumber(s.matrix.R); } },
+            { "T", "pokusa zdrady",
+                [](Simulation& s, const std::string& v) { return setFloat(s.matrix.T, v); },
+                [](const Simulation& s) { return formatNumber(s.matrix.T); } },
+            { "S", "wypłata frajera",
+                [](Simulation& s, const std::string& v) { return setFloat(s.matrix.S, v); },
+                [](const Simulation& s) { return formatNumber(s.matrix.S); } },
+            { "P", "kara za obustronną zdradę",
+                [](Simulation& s, const std::string& v) { return setFloat(s.matrix.P, v); },
+                [](const Simulation& s) { return formatNumber(s.matrix.P); } },
+            { "strategies", "lista po przecinku: allc,alld,tft,pavlov,disc", parseStrategies, formatStrategies },
+            { "density", "gęstość startowa (0..1)",
+                [](Simulation& s, const std::string& v) { return setProbability(s.density, v); },
+                [](const Simulation& s) { return formatNumber(s.density); } },
+            { "mode", "imitation | deathbirth",
+                [](Simulation& s, const std::string& v) { return parseEnum(v, modeNames, s.mode); },
+                [](const Simulation& s) { return formatEnum(modeNames, s.mode); } },
+            { "update_rule", "bestneighbor | fermi",
+                [](Simulation& s, const std::string& v) { return parseEnum(v, ruleNames, s.updateRule); },
+                [](const Simulation& s) { return formatEnum(ruleNames, s.updateRule); } },
+            { "birth_scheduling", "serial | parallel",
+                [](Simulation& s, const std::string& v) { return parseEnum(v, schedulingNames, s.birthScheduling); },
+                [](const Simulation& s) { return formatEnum(schedulingNames, s.birthScheduling); } },
+            { "migration_scheduling", "serial | parallel",
+                [](Simulation& s, const std::string& v) { return parseEnum(v, schedulingNames, s.migrationScheduling); },
+                [](const Simulation& s) { return formatEnum(schedulingNames, s.migrationScheduling); } },
+            { "move_prob", "szansa ruchu na pokolenie (0..1)",
+                [](Simulation& s, const std::string& v) { return setProbability(s.moveProb, v); },
+                [](const Simulation& s) { return formatNumber(s.moveProb); } },
+            { "move_epsilon", "minimalna poprawa do ruchu",
+                [](Simulation& s, const std::string& v) { return setFloat(s.moveEpsilon, v); },
+                [](const Simulation& s) { return formatNumber(s.moveEpsilon); } },
+            { "rounds", "rundy IPD na pokolenie",
+                [](Simulation& s, const std::string& v) { return setInt(s.roundsPerGeneration, v, 1); },
+                [](const Simulation& s) { return formatNumber(s.roundsPerGeneration); } },
+            { "reputation_alpha", "szybkość EMA reputacji",
+                [](Simulation& s, const std::string& v) { return setFloat(s.reputationAlpha, v); },
+                [](const Simulation& s) { return formatNumber(s.reputationAlpha); } },
+            { "reputation_threshold", "próg zaufania Dyskryminatora",
+                [](Simulation& s, const std::string& v) { return setFloat(s.reputationThreshold, v); },
+                [](const Simulation& s) { return formatNumber(s.reputationThreshold); } },
+            { "reproduction_prob", "szansa narodzin na pustym polu (0..1)",
+                [](Simulation& s, const std::string& v) { return setProbability(s.reproductionProb, v); },
+                [](const Simulation& s) { return formatNumber(s.reproductionProb); } },
+            { "death_prob", "śmiertelność (0..1)",
+                [](Simulation& s, const std::string& v) { return setProbability(s.deathProb, v); },
+                [](const Simulation& s) { return formatNumber(s.deathProb); } },
+            { "selection_beta", "siła selekcji",
+                [](Simulation& s, const std::string& v) { return setFloat(s.selectionBeta, v); },
+                [](const Simulation& s) { return formatNumber(s.selectionBeta); } },
+            { "normalize_payoff", "true | false",
+                [](Simulation& s, const std::string& v) { return parseBool(v, s.normalizePayoff); },
+                [](const Simulation& s) { return formatBool(s.normalizePayoff); } },
+            { "mutation_rate", "szansa mutacji (0..1)",
+                [](Simulation& s, const std::string& v) { return setProbability(s.mutationRate, v); },
+                [](const Simulation& s) { return formatNumber(s.mutationRate); } },
+            { "fermi_k", "szum reguły Fermiego",
+                [](Simulation& s, const std::string& v) {
+                    float k;
+                    if (!parseNumber(v, k) || !(k > 0.0f)) return false;
+                    s.fermiK = k;
+                    return true; },
+                [](const Simulation& s) { return formatNumber(s.fermiK); } },
+            { "seed", "ziarno generatora (uint64)",
+                [](Simulation& s, const std::string& v) { return parseNumber(v, s.seed); },
+                [](const Simulation& s) { return formatNumber(s.seed); } },
+            { "export_format", "csv | binary (kolumnowy log, zob. social-evolution-log)",
+                [](Simulation& s, const std::string& v) { return parseEnum(v, formatNames, s.exportFormat); },
+                [](const Simulation& s) { return formatEnum(formatNames, s.exportFormat); } },
+            { "export_compression", "kompresja bloków logu binarnego (true | false)",
+                [](Simulation& s, const std::string& v) { return parseBool(v, s.exportCompression); },
+                [](const Simulation& s) { return formatBool(s.exportCompression); } },
+            { "export_timings", "kolumny czasów faz w CSV (true | false)",
+                [](Simulation& s, const std::string& v) { return parseBool(v, s.exportTimings); },
+                [](const Simulation& s) { return formatBool(s.exportTimings); } },
+        };
+        return table;
+    }
+}
+
+namespace SimulationConfig {
+
+    bool apply(Simulation& sim, const std::string& key, const std::string& value, std::string& error) {
+        for (const Setting& setting : settings()) {
+            if (key != setting.key) continue;
+            if (setting.set(sim, value)) return true;
+            error = "zła wartość dla '" + key + "': '" + value + "' (" + setting.help + ")";
+            return false;
+        }
+        error = "nieznany parametr '" + key + "'";
+        return false;
+    }
+
+    bool loadFile(const std::string& path, Entries& out, std::string& error) {
+        std::ifstream f(path);
+        if (!f) {
+            error = "nie można otworzyć pliku '" + path + "'";
+            return false;
+        }
+
+        std::string line;
+        int lineNo = 0;
+        while (std::getline(f, line)) {
+            lineNo++;
+            size_t hash = line.find('#');
+            if (hash != std::string::npos) line.erase(hash);
+            line = trim(line);
+            if (line.empty()) continue;
+
+            size_t eq = line.find('=');
+            if (eq == std::string::npos) {
+                error = path + ":" + std::to_string(lineNo) + ": oczekiwano 'klucz = wartość'";
+                return false;
+            }
+            out.emplace_back(trim(line.substr(0, eq)), trim(line.substr(eq + 1)));
+        }
+        return true;
+    }
+
+    Entries currentValues(const Simulation& sim) {
+        Entries out;
+        for (const Setting& setting : settings()) {
+            out.emplace_back(setting.key, setting.get(sim));
+        }
+        return out;
+    }
+
+    std::string describeKeys() {
+        std::string out;
+        for (const Setting& setting : settings()) {
+            const std::string key = setting.key;
+            out += "  " + key;
+            out.append(key.size() < 22 ? 22 - key.size() : 1, ' ');
+            out += setting.help;
+            out += "\n";
+        }
+        return out;
+    }
+}
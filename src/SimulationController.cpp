@@ -0,0 +1,305 @@
+#include "SimulationController.hpp"
+#include "Trace.hpp"
+
+SimulationParams SimulationParams::capture(const Simulation& sim) {
+    SimulationParams p;
+    p.useAlwaysCooperate = sim.useAlwaysCooperate;
+    p.useAlwaysDefect = sim.useAlwaysDefect;
+    p.useTitForTat = sim.useTitForTat;
+    p.usePavlov = sim.usePavlov;
+    p.useDiscriminator = sim.useDiscriminator;
+    p.density = sim.density;
+    p.seed = sim.seed;
+
+    p.matrix = sim.matrix;
+    p.normalizePayoff = sim.normalizePayoff;
+
+    p.boundary = sim.grid.boundary;
+    p.neighborhood = sim.grid.neighborhood;
+
+    p.mode = sim.mode;
+    p.updateRule = sim.updateRule;
+    p.fermiK = sim.fermiK;
+    p.mutationRate = sim.mutationRate;
+    p.reproductionProb = sim.reproductionProb;
+    p.deathProb = sim.deathProb;
+    p.selectionBeta = sim.selectionBeta;
+    p.birthScheduling = sim.birthScheduling;
+
+    p.moveProb = sim.moveProb;
+    p.moveEpsilon = sim.moveEpsilon;
+    p.migrationScheduling = sim.migrationScheduling;
+
+    p.roundsPerGeneration = sim.roundsPerGeneration;
+    p.reputationAlpha = sim.reputationAlpha;
+    p.reputationThreshold = sim.reputationThreshold;
+
+    p.exportCsvEnabled = sim.exportCsvEnabled;
+    p.exportTimings = sim.exportTimings;
+    return p;
+}
+
+void SimulationParams::applyTo(Simulation& sim) const {
+    sim.useAlwaysCooperate = useAlwaysCooperate;
+    sim.useAlwaysDefect = useAlwaysDefect;
+    sim.useTitForTat = useTitForTat;
+    sim.usePavlov = usePavlov;
+    sim.useDiscriminator = useDiscriminator;
+    sim.density = density;
+    sim.seed = seed;
+
+    sim.matrix = matrix;
+    sim.normalizePayoff = normalizePayoff;
+
+    // Topologia przelicza się sama na początku następnego pokolenia
+    sim.grid.boundary = boundary;
+    sim.grid.neighborhood = neighborhood;
+
+    sim.mode = mode;
+    sim.updateRule = updateRule;
+    sim.fermiK = fermiK;
+    sim.mutationRate = mutationRate;
+    sim.reproductionProb = reproductionProb;
+    sim.deathProb = deathProb;
+    sim.selectionBeta = selectionBeta;
+    sim.birthScheduling = birthScheduling;
+
+    sim.moveProb = moveProb;
+    sim.moveEpsilon = moveEpsilon;
+    sim.migrationScheduling = migrationScheduling;
+
+    sim.roundsPerGeneration = roundsPerGeneration;
+    sim.reputationAlpha = reputationAlpha;
+    sim.reputationThreshold = reputationThreshold;
+
+    sim.exportCsvEnabled = exportCsvEnabled;
+    sim.exportTimings = exportTimings;
+}
+
+void SimulationSnapshot::capture(const Simulation& sim, bool withGrid) {
+    generation = sim.generation;
+    width = sim.grid.width;
+    height = sim.grid.height;
+
+    // Przypisania wektorów używają istniejącej pojemności, więc przy stałej siatce nie alokują
+    hasGrid = withGrid;
+    if (withGrid) {
+        alive = sim.agents.alive;
+        type = sim.agents.type;
+        visualAction = sim.agents.visualAction;
+        changed = sim.agents.changed;
+    }
+
+    lastMetrics = sim.lastMetrics;
+    history = sim.history;
+    cooperationRate = sim.cooperationRate();
+    times = sim.timers.last();
+}
+
+SimulationController::SimulationController(Simulation& s, bool threadedMode) : sim(s) {
+    // Pierwszy stan jest gotowy od razu, zanim ruszy silnik
+    captureInto(buffers[front]);
+    consumed = false;
+    dirty = false;
+
+    if (threadedMode) startWorker();
+}
+
+SimulationController::~SimulationController() {
+    stopWorker();
+}
+
+void SimulationController::setThreaded(bool on) {
+    if (on == threaded()) return;
+    if (on) startWorker();
+    else stopWorker();
+}
+
+void SimulationController::startWorker() {
+    quit.store(false, std::memory_order_relaxed);
+    worker = std::thread(&SimulationController::workerLoop, this);
+}
+
+void SimulationController::stopWorker() {
+    if (!worker.joinable()) return;
+    quit.store(true, std::memory_order_release);
+    wake();
+    worker.join();
+}
+
+void SimulationController::setRunning(bool on) {
+    runFlag.store(on, std::memory_order_relaxed);
+    wake();
+}
+
+void SimulationController::setCaptureGrid(bool on) {
+    if (gridFlag.exchange(on, std::memory_order_relaxed) == on) return;
+    post([](Simulation&) {}); // puste polecenie: stan zostanie opublikowany ponownie (z planszą albo bez)
+}
+
+void SimulationController::post(Command cmd) {
+    while (!commands.push(std::move(cmd))) {
+        // Bez wątku silnika nikt inny kolejki nie opróżni
+        if (!threaded()) {
+            std::lock_guard<std::mutex> lock(engineMutex);
+            if (drainCommands()) dirty = true;
+            continue;
+        }
+        std::this_thread::yield();
+    }
+    wake();
+}
+
+void SimulationController::wake() {
+    wakeups.fetch_add(1, std::memory_order_release);
+    wakeups.notify_one();
+}
+
+bool SimulationController::drainCommands() {
+    bool any = false;
+    Command cmd;
+    while (commands.pop(cmd)) {
+        cmd(sim);
+        any = true;
+    }
+    cmd = nullptr;
+    return any;
+}
+
+void SimulationController::countGeneration() {
+    const auto now = std::chrono::steady_clock::now();
+    if (rateCount == 0 && generationsPerSecond == 0.0) rateStart = now;
+    rateCount++;
+
+    const double elapsed = std::chrono::duration<double>(now - rateStart).count();
+    if (elapsed >= 0.5) {
+        generationsPerSecond = rateCount / elapsed;
+        rateCount = 0;
+        rateStart = now;
+    }
+}
+
+bool SimulationController::publish() {
+    int back;
+    {
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        if (!consumed) return false;
+        back = 1 - front;
+        if (reading == back) return false;
+    }
+
+    // GUI czyta tylko front, więc drugi bufor można wypełniać bez blokady
+    captureInto(buffers[back]);
+
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    front = back;
+    consumed = false;
+    return true;
+}
+
+void SimulationController::captureInto(SimulationSnapshot& snap) {
+    snap.capture(sim, captureGrid());
+    snap.sequence = ++published;
+    snap.generationsPerSecond = generationsPerSecond;
+    snap.generationsPerFrame = generationsPerFrame;
+
+    // Zmiany od tej chwili trafią do następnej publikacji. Bez planszy też czyścimy: luka
+    // w numerach każe rysującemu odświeżyć całą planszę.
+    sim.agents.clearChanged();
+}
+
+void SimulationController::advance(double budgetMs) {
+    using Clock = std::chrono::steady_clock;
+
+    bool worked = drainCommands();
+    if (running()) {
+        const Clock::time_point start = Clock::now();
+        double elapsedMs = 0.0;
+        int steps = 0;
+
+        // Przynajmniej jedno pokolenie; kolejne, dopóki następne (wg średniej) mieści się w budżecie
+        do {
+            const Clock::time_point stepStart = Clock::now();
+            sim.step();
+            countGeneration();
+            steps++;
+
+            const Clock::time_point stepEnd = Clock::now();
+            const double stepMs = std::chrono::duration<double, std::milli>(stepEnd - stepStart).count();
+            stepEstimateMs = (stepEstimateMs > 0.0) ? 0.9 * stepEstimateMs + 0.1 * stepMs : stepMs;
+            elapsedMs = std::chrono::duration<double, std::milli>(stepEnd - start).count();
+        } while (running() && elapsedMs + stepEstimateMs <= budgetMs);
+
+        generationsPerFrame = steps;
+        worked = true;
+    }
+    else {
+        rateCount = 0;
+        generationsPerSecond = 0.0;
+        generationsPerFrame = 0;
+    }
+    if (worked) dirty = true;
+    if (dirty && publish()) dirty = false;
+}
+
+void SimulationController::frame() {
+    if (threaded()) return;
+
+    std::lock_guard<std::mutex> lock(engineMutex);
+    advance(frameBudgetMs);
+}
+
+void SimulationController::workerLoop() {
+    Trace::setThreadName("Symulacja");
+
+    while (!quit.load(std::memory_order_acquire)) {
+        const uint32_t seen = wakeups.load(std::memory_order_acquire);
+
+        // GUI czeka w exclusive(): ustępujemy między pokoleniami
+        if (exclusiveWaiting.load(std::memory_order_acquire)) {
+            exclusiveWaiting.wait(true, std::memory_order_acquire);
+            continue;
+        }
+
+        bool idle;
+        {
+            std::lock_guard<std::mutex> lock(engineMutex);
+            advance(0.0); // wątek i tak liczy bez przerwy; budżet dotyczy tylko klatek
+            idle = !running() && commands.empty();
+        }
+
+        // Bez pracy śpimy do polecenia, startu, odbioru stanu albo zamknięcia
+        if (idle) wakeups.wait(seen, std::memory_order_acquire);
+    }
+}
+
+void SimulationController::lockEngine() {
+    exclusiveWaiting.store(true, std::memory_order_release);
+    engineMutex.lock();
+    if (drainCommands()) dirty = true; // polecenia wysłane wcześniej wykonują się przed f
+}
+
+void SimulationController::unlockEngine() {
+    dirty = true;
+    if (!threaded() && publish()) dirty = false;
+    engineMutex.unlock();
+
+    exclusiveWaiting.store(false, std::memory_order_release);
+    exclusiveWaiting.notify_all();
+    wake();
+}
+
+const SimulationSnapshot& SimulationController::acquire() {
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    reading = front;
+    consumed = true;
+    return buffers[reading];
+}
+
+void SimulationController::release() {
+    {
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        reading = -1;
+    }
+    wake(); // silnik mógł czekać z nowym stanem na odbiór poprzedniego
+}
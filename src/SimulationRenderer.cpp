@@ -1,26 +1,373 @@
 #include "SimulationRenderer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
 
-SimulationRenderer::SimulationRenderer(Simulation& s)
-    : sim(s)
-{
-    cellSize = (float)LEFT_PANEL_WIDTH / sim.grid.width;
+sf::Color agentColor(AgentType type, Action visualAction) {
+    // Krok 1: Wybierz kolor bazowy (Tożsamość)
+    sf::Color baseColor = sf::Color::White;
+
+    switch (type) {
+    case AgentType::AlwaysCooperate: return sf::Color(50, 255, 50);
+    case AgentType::AlwaysDefect:    return sf::Color(255, 50, 50);
+    case AgentType::TitForTat:       baseColor = sf::Color(50, 100, 255); break;
+    case AgentType::Pavlov:          baseColor = sf::Color(255, 255, 50); break;
+    case AgentType::Discriminator:   baseColor = sf::Color(180, 60, 255); break;
+    }
+
+    // Krok 2: Cieniowanie na podstawie DOMINUJĄCEJ akcji (visualAction)
+    // To obliczamy w Simulation.cpp
+    if (visualAction == Action::Cooperate) {
+        return baseColor;
+    }
+    else {
+        return sf::Color(
+            (baseColor.r * 0.4f),
+            (baseColor.g * 0.4f),
+            (baseColor.b * 0.4f)
+        );
+    }
+}
+
+GridView GridView::fit(int width, int height, sf::Vector2f panel) {
+    GridView v;
+    if (width > 0 && height > 0) v.scale = std::min(panel.x / width, panel.y / height);
+    return v;
+}
+
+uint32_t TileCounts::alive() const {
+    uint32_t n = 0;
+    for (uint32_t c : perType) n += c;
+    return n;
 }
 
-void SimulationRenderer::draw(sf::RenderTarget& target) {
+TileCounts& TileCounts::operator+=(const TileCounts& o) {
+    for (int t = 0; t < AGENT_TYPE_COUNT; ++t) perType[t] += o.perType[t];
+    coop += o.coop;
+    return *this;
+}
+
+static sf::Color mix(sf::Color a, sf::Color b, float t) {
+    return sf::Color(
+        (uint8_t)(a.r + (b.r - a.r) * t),
+        (uint8_t)(a.g + (b.g - a.g) * t),
+        (uint8_t)(a.b + (b.b - a.b) * t)
+    );
+}
+
+SimulationRenderer::SimulationRenderer() {
+    for (int t = 0; t < AGENT_TYPE_COUNT; ++t) {
+        palette[t * 2 + 0] = agentColor((AgentType)t, Action::Cooperate);
+        palette[t * 2 + 1] = agentColor((AgentType)t, Action::Defect);
+    }
+}
+
+// Czy w bitsecie jest ustawiony któryś bit z [begin, end)
+static bool anyChanged(const std::vector<uint64_t>& bits, int begin, int end) {
+    const int first = begin >> 6;
+    const int last = (end - 1) >> 6;
+    const uint64_t headMask = ~0ull << (begin & 63);
+    const uint64_t tailMask = ~0ull >> (63 - ((end - 1) & 63));
+
+    if (first == last) return (bits[first] & headMask & tailMask) != 0;
+    if (bits[first] & headMask) return true;
+    for (int w = first + 1; w < last; ++w) {
+        if (bits[w]) return true;
+    }
+    return (bits[last] & tailMask) != 0;
+}
+
+sf::Color SimulationRenderer::tileColor(const TileCounts& c, uint32_t cells) const {
+    const uint32_t alive = c.alive();
+    if (alive == 0) return emptyColor;
+
+    const float coop = (float)c.coop / alive;
+    sf::Color color;
+    if (shading == TileShading::MajorityType) {
+        int best = 0;
+        for (int t = 1; t < AGENT_TYPE_COUNT; ++t) {
+            if (c.perType[t] > c.perType[best]) best = t;
+        }
+        // Pomiędzy odcieniem zdrady i współpracy, jak pojedyncza komórka w skrajnych przypadkach
+        color = mix(palette[best * 2 + 1], palette[best * 2 + 0], coop);
+    }
+    else {
+        color = sf::Color((uint8_t)(255.0f * (1.0f - coop)), (uint8_t)(255.0f * coop), 51);
+    }
+
+    // Rzadko zaludniony kafelek blednie w stronę pustego pola
+    return mix(emptyColor, color, (float)alive / cells);
+}
+
+TileCounts SimulationRenderer::countCells(const SimulationSnapshot& snap, int x0, int y0, int size) const {
+    TileCounts c;
+    const int x1 = std::min(x0 + size, snap.width);
+    const int y1 = std::min(y0 + size, snap.height);
+    for (int y = y0; y < y1; ++y) {
+        const int row = y * snap.width;
+        for (int x = x0; x < x1; ++x) {
+            const int idx = row + x;
+            if (!snap.alive[idx]) continue;
+            c.perType[(int)snap.type[idx]]++;
+            if (snap.visualAction[idx] == Action::Cooperate) c.coop++;
+        }
+    }
+    return c;
+}
+
+TileCounts SimulationRenderer::tileCounts(const SimulationSnapshot& snap, int level, int tx, int ty) const {
+    if (level < PYRAMID_FIRST_LEVEL) return countCells(snap, tx << level, ty << level, 1 << level);
+
+    const PyramidLevel& lv = pyramid[level - PYRAMID_FIRST_LEVEL];
+    return lv.tiles[(size_t)ty * lv.width + tx];
+}
+
+void SimulationRenderer::updatePyramid(const SimulationSnapshot& snap) {
+    const int w = snap.width;
+    const int h = snap.height;
+    const int cells = w * h;
+    const bool sameGrid = (w == gridWidth && h == gridHeight);
+
+    if (sameGrid && pyramidSequence != 0 && snap.sequence == pyramidSequence) return;
+
+    if (!sameGrid) {
+        pyramid.clear();
+        for (int level = PYRAMID_FIRST_LEVEL;; ++level) {
+            PyramidLevel lv;
+            lv.width = (w + (1 << level) - 1) >> level;
+            lv.height = (h + (1 << level) - 1) >> level;
+            lv.tiles.assign((size_t)lv.width * lv.height, TileCounts{});
+            lv.dirty.assign((size_t)lv.width * lv.height, 0);
+            pyramid.push_back(std::move(lv));
+            if (pyramid.back().width == 1 && pyramid.back().height == 1) break;
+        }
+        gridWidth = w;
+        gridHeight = h;
+    }
+
+    PyramidLevel& base = pyramid[0];
+    const int words = (int)snap.changed.size();
+    const bool incremental = sameGrid && pyramidSequence != 0 && snap.sequence == pyramidSequence + 1
+        && words == (cells + 63) / 64;
+
+    if (!incremental) {
+        std::fill(base.dirty.begin(), base.dirty.end(), 1);
+    }
+    else {
+        // Kafelki ze zmienionymi komórkami. Kolejne bity słowa w tym samym wierszu i kafelku
+        // dałyby ten sam kafelek, więc przeskakujemy do końca kafelka.
+        constexpr int TILE = 1 << PYRAMID_FIRST_LEVEL;
+#pragma omp parallel for schedule(static) if (words >= 4096)
+        for (int i = 0; i < words; ++i) {
+            uint64_t bits = snap.changed[i];
+            while (bits) {
+                const int bit = std::countr_zero(bits);
+                const int idx = i * 64 + bit;
+                if (idx >= cells) break;
+
+                const int x = idx % w;
+                const int y = idx / w;
+                std::atomic_ref<uint8_t>(base.dirty[(size_t)(y >> PYRAMID_FIRST_LEVEL) * base.width + (x >> PYRAMID_FIRST_LEVEL)])
+                    .store(1, std::memory_order_relaxed);
+
+                const int next = bit + std::min(TILE - (x & (TILE - 1)), w - x);
+                if (next >= 64) break;
+                bits &= ~0ull << next;
+            }
+        }
+    }
+
+    // Przeliczamy oznaczone kafelki od dołu; każdy oznacza rodzica na poziomie wyżej
+    const int levels = (int)pyramid.size();
+    for (int k = 0; k < levels; ++k) {
+        PyramidLevel& lv = pyramid[k];
+        const int level = PYRAMID_FIRST_LEVEL + k;
+        const int n = lv.width * lv.height;
 
-    sf::RectangleShape cell({ cellSize - 1.f, cellSize - 1.f });
+#pragma omp parallel for schedule(static) if (n >= 4096)
+        for (int t = 0; t < n; ++t) {
+            if (!lv.dirty[t]) continue;
+            lv.dirty[t] = 0;
 
-    for (int y = 0; y < sim.grid.height; ++y) {
-        for (int x = 0; x < sim.grid.width; ++x) {
-            cell.setPosition({ x * cellSize, y * cellSize });
-            Agent* a = sim.grid.get(x, y);
-            if (!a) {
-                cell.setFillColor(sf::Color(60, 60, 60)); // puste pole
+            const int tx = t % lv.width;
+            const int ty = t / lv.width;
+            if (k == 0) {
+                lv.tiles[t] = countCells(snap, tx << level, ty << level, 1 << level);
             }
             else {
-                cell.setFillColor(a->getColor());
+                const PyramidLevel& below = pyramid[k - 1];
+                TileCounts c;
+                for (int cy = 2 * ty; cy < std::min(2 * ty + 2, below.height); ++cy) {
+                    for (int cx = 2 * tx; cx < std::min(2 * tx + 2, below.width); ++cx) {
+                        c += below.tiles[(size_t)cy * below.width + cx];
+                    }
+                }
+                lv.tiles[t] = c;
+            }
+
+            if (k + 1 < levels) {
+                PyramidLevel& above = pyramid[k + 1];
+                std::atomic_ref<uint8_t>(above.dirty[(size_t)(ty >> 1) * above.width + (tx >> 1)])
+                    .store(1, std::memory_order_relaxed);
             }
-            target.draw(cell);
         }
     }
+
+    pyramidSequence = snap.sequence;
+}
+
+SimulationRenderer::ViewImage SimulationRenderer::layout(const SimulationSnapshot& snap, const GridView& view, sf::Vector2f panel) const {
+    ViewImage img;
+    img.shading = shading;
+    if (view.scale <= 0.0f || panel.x <= 0.0f || panel.y <= 0.0f) return img;
+
+    // Najniższy poziom, na którym jednostka zajmuje co najmniej piksel (najwyżej cała plansza)
+    const int largest = std::max(snap.width, snap.height);
+    int level = 0;
+    while ((float)(1 << level) * view.scale < 1.0f && (1 << level) < largest) level++;
+
+    const int unit = 1 << level;
+    const float unitSize = unit * view.scale; // piksele ekranu na jednostkę
+    const int unitsX = (snap.width + unit - 1) >> level;
+    const int unitsY = (snap.height + unit - 1) >> level;
+
+    const int x0 = std::clamp((int)std::floor(view.originX / unit), 0, unitsX);
+    const int y0 = std::clamp((int)std::floor(view.originY / unit), 0, unitsY);
+    const int x1 = std::clamp((int)std::ceil((view.originX + panel.x / view.scale) / unit), 0, unitsX);
+    const int y1 = std::clamp((int)std::ceil((view.originY + panel.y / view.scale) / unit), 0, unitsY);
+
+    img.level = level;
+    img.x0 = x0;
+    img.y0 = y0;
+    img.cols = std::max(0, x1 - x0);
+    img.rows = std::max(0, y1 - y0);
+    img.position = { ((float)x0 * unit - view.originX) * view.scale, ((float)y0 * unit - view.originY) * view.scale };
+    img.size = { img.cols * unitSize, img.rows * unitSize };
+    return img;
+}
+
+void SimulationRenderer::fillRows(const SimulationSnapshot& snap, const std::vector<uint8_t>* onlyRows) {
+    const int cols = image.cols;
+    const int rows = image.rows;
+    const int level = image.level;
+    const int unit = 1 << level;
+
+    // Małe obrazy nie opłacają się zespołowi wątków
+#pragma omp parallel for schedule(static) if (cols * rows >= 65536)
+    for (int r = 0; r < rows; ++r) {
+        if (onlyRows && !(*onlyRows)[r]) continue;
+
+        sf::Color* out = pixels.data() + (size_t)r * cols;
+        const int ty = image.y0 + r;
+        if (level == 0) {
+            const int row = ty * snap.width + image.x0;
+            for (int c = 0; c < cols; ++c) out[c] = cellColor(snap, row + c);
+        }
+        else {
+            const int cellsY = std::min(unit, snap.height - ty * unit);
+            for (int c = 0; c < cols; ++c) {
+                const int tx = image.x0 + c;
+                const int cellsX = std::min(unit, snap.width - tx * unit);
+                out[c] = tileColor(tileCounts(snap, level, tx, ty), (uint32_t)(cellsX * cellsY));
+            }
+        }
+    }
+
+    // sf::Color to cztery bajty r, g, b, a, czyli dokładnie układ RGBA oczekiwany przez update()
+    static_assert(sizeof(sf::Color) == 4, "sf::Color musi mieć układ RGBA8");
+    const auto upload = [&](int first, int count) {
+        viewTexture.update(reinterpret_cast<const std::uint8_t*>(pixels.data() + (size_t)first * cols),
+            { (unsigned)cols, (unsigned)count }, { 0u, (unsigned)first });
+        uploadRows += count;
+    };
+
+    uploadRows = 0;
+    if (!onlyRows) {
+        upload(0, rows);
+        return;
+    }
+
+    // Wysyłka pasami kolejnych zmienionych wierszy. Kilka czystych wierszy w środku pasa
+    // kosztuje mniej niż osobne wywołanie update(), więc krótkie przerwy są sklejane.
+    constexpr int MERGE_GAP = 4;
+    int r = 0;
+    while (r < rows) {
+        if (!(*onlyRows)[r]) {
+            ++r;
+            continue;
+        }
+
+        const int bandStart = r;
+        int bandEnd = r + 1; // za ostatnim zmienionym wierszem pasa
+        for (int next = bandEnd; next < rows && next - bandEnd <= MERGE_GAP; ++next) {
+            if ((*onlyRows)[next]) bandEnd = next + 1;
+        }
+
+        upload(bandStart, bandEnd - bandStart);
+        r = bandEnd;
+    }
+}
+
+void SimulationRenderer::update(const SimulationSnapshot& snap, const GridView& view, sf::Vector2f panel) {
+    if (snap.width <= 0 || snap.height <= 0) return;
+
+    // Piramida idzie za każdym nowym stanem, także przy przybliżeniu, żeby oddalenie było od razu gotowe
+    updatePyramid(snap);
+
+    ViewImage next = layout(snap, view, panel);
+    if (next.cols == 0 || next.rows == 0) {
+        image = next; // nic z planszy nie jest widoczne
+        drawnSequence = 0;
+        uploadRows = 0;
+        return;
+    }
+
+    // Tekstura tylko rośnie (najwyżej do rozmiaru panelu plus brzeg), nowy rozmiar gubi zawartość
+    bool valid = drawnSequence != 0;
+    if ((unsigned)next.cols > textureSize.x || (unsigned)next.rows > textureSize.y) {
+        const sf::Vector2u size(std::max(textureSize.x, (unsigned)next.cols), std::max(textureSize.y, (unsigned)next.rows));
+        if (!viewTexture.resize(size)) return;
+        viewTexture.setSmooth(false); // najbliższy sąsiad: komórki zostają ostrymi kwadratami
+        textureSize = size;
+        valid = false;
+    }
+
+    // Przesunięcie o ułamek jednostki zmienia tylko położenie obrazu, nie jego treść
+    const bool sameArea = valid && image.sameArea(next);
+    image.position = next.position;
+    image.size = next.size;
+
+    if (sameArea && snap.sequence == drawnSequence) {
+        uploadRows = 0; // ten sam stan co w teksturze
+        return;
+    }
+
+    const size_t words = ((size_t)snap.width * snap.height + 63) / 64;
+    if (sameArea && next.level == 0 && snap.sequence == drawnSequence + 1 && snap.changed.size() == words) {
+        // Pojedyncze komórki: tylko widoczne wiersze, w których coś się zmieniło
+        rowChanged.assign(image.rows, 0);
+        for (int r = 0; r < image.rows; ++r) {
+            const int begin = (image.y0 + r) * snap.width + image.x0;
+            rowChanged[r] = anyChanged(snap.changed, begin, begin + image.cols);
+        }
+        fillRows(snap, &rowChanged);
+    }
+    else {
+        image = next;
+        pixels.resize((size_t)image.cols * image.rows);
+        fillRows(snap, nullptr);
+    }
+    drawnSequence = snap.sequence;
+}
+
+void SimulationRenderer::draw(sf::RenderTarget& target, const SimulationSnapshot& snap) {
+    const sf::Vector2f panel((float)target.getSize().x, (float)target.getSize().y);
+    update(snap, GridView::fit(snap.width, snap.height, panel), panel);
+    if (!hasImage()) return;
+
+    sf::Sprite sprite(viewTexture, imageRect());
+    sprite.setPosition(image.position);
+    sprite.setScale({ image.size.x / image.cols, image.size.y / image.rows });
+    target.draw(sprite);
 }
@@ -0,0 +1,193 @@
+#include "Trace.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+    struct Event {
+        const char* name;
+        int64_t begin; // ns od początku sesji
+        int64_t end;
+    };
+
+    // Bufor jednego wątku: pisze tylko właściciel, count publikowany z release,
+    // więc zapis do pliku widzi wyłącznie kompletne zdarzenia
+    struct ThreadBuffer {
+        std::vector<Event> events;
+        std::atomic<size_t> count{ 0 };
+        std::atomic<size_t> dropped{ 0 };
+        uint64_t session = 0;
+        int tid = 0;
+        std::string name;
+    };
+
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> registry; // bufory żyją do końca procesu
+    std::atomic<uint64_t> session{ 0 };
+    size_t capacity = Trace::DEFAULT_EVENTS_PER_THREAD;
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    thread_local ThreadBuffer* localBuffer = nullptr;
+    thread_local const char* pendingName = nullptr;
+
+    // Bufor bieżącego wątku w bieżącej sesji (rejestracja tylko przy pierwszym zdarzeniu)
+    ThreadBuffer* threadBuffer() {
+        const uint64_t current = session.load(std::memory_order_acquire);
+        if (localBuffer && localBuffer->session == current) return localBuffer;
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+
+        if (!localBuffer) {
+            registry.push_back(std::make_unique<ThreadBuffer>());
+            localBuffer = registry.back().get();
+            localBuffer->tid = (int)registry.size();
+
+            if (pendingName) {
+                localBuffer->name = pendingName;
+            }
+            else {
+#ifdef _OPENMP
+                if (omp_in_parallel()) {
+                    localBuffer->name = "OpenMP " + std::to_string(omp_get_thread_num());
+                }
+#endif
+                if (localBuffer->name.empty()) localBuffer->name = "Wątek " + std::to_string(localBuffer->tid);
+            }
+        }
+
+        if (localBuffer->events.size() != capacity) {
+            localBuffer->events.assign(capacity, Event{});
+        }
+        localBuffer->count.store(0, std::memory_order_relaxed);
+        localBuffer->dropped.store(0, std::memory_order_relaxed);
+        localBuffer->session = current;
+        return localBuffer;
+    }
+
+    void writeEscaped(std::ostream& out, const std::string& s) {
+        for (char c : s) {
+            if (c == '"' || c == '\\') out << '\\' << c;
+            else if ((unsigned char)c < 0x20) out << ' ';
+            else out << c;
+        }
+    }
+}
+
+std::atomic<bool> Trace::detail::recording{ false };
+
+int64_t Trace::detail::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Trace::detail::record(const char* name, int64_t begin, int64_t end) {
+    ThreadBuffer* buffer = threadBuffer();
+
+    const size_t n = buffer->count.load(std::memory_order_relaxed);
+    if (n >= buffer->events.size()) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer->events[n] = { name, begin, end };
+    buffer->count.store(n + 1, std::memory_order_release);
+}
+
+void Trace::start(size_t eventsPerThread) {
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        capacity = eventsPerThread > 0 ? eventsPerThread : 1;
+        epoch = std::chrono::steady_clock::now();
+
+        // Stare zdarzenia znikają z zapisu od razu, nawet dla wątków, które już nic nie nagrają
+        for (auto& buffer : registry) buffer->count.store(0, std::memory_order_relaxed);
+    }
+
+    session.fetch_add(1, std::memory_order_acq_rel);
+
+    // Bufory (kilka MB na wątek) przydzielamy teraz, także wątkom zespołu OpenMP: inaczej każdy
+    // alokowałby swój przy pierwszym zdarzeniu, pod registryMutex, w środku regionu równoległego,
+    // a pierwsze nagrane pokolenie pokazywałoby sztuczną serializację i nierówne obciążenie.
+    threadBuffer();
+#pragma omp parallel
+    {
+        threadBuffer();
+    }
+    detail::recording.store(true, std::memory_order_release);
+}
+
+void Trace::stop() {
+    detail::recording.store(false, std::memory_order_release);
+}
+
+void Trace::setThreadName(const char* name) {
+    pendingName = name;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    if (localBuffer) localBuffer->name = name;
+}
+
+size_t Trace::eventCount() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    size_t total = 0;
+    for (const auto& buffer : registry) total += buffer->count.load(std::memory_order_acquire);
+    return total;
+}
+
+size_t Trace::droppedCount() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    size_t total = 0;
+    for (const auto& buffer : registry) total += buffer->dropped.load(std::memory_order_relaxed);
+    return total;
+}
+
+bool Trace::writeChromeJson(const std::string& path, std::string& error) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        error = "nie można otworzyć pliku '" + path + "'";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    const uint64_t current = session.load(std::memory_order_acquire);
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    char line[96];
+
+    for (const auto& buffer : registry) {
+        if (buffer->session != current) continue;
+
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+            << ",\"args\":{\"name\":\"";
+        writeEscaped(out, buffer->name);
+        out << "\"}}";
+        first = false;
+
+        // Czas w mikrosekundach (jednostka formatu), z dokładnością do ns
+        const size_t n = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < n; ++i) {
+            const Event& e = buffer->events[i];
+            out << ",\n{\"name\":\"";
+            writeEscaped(out, e.name);
+            std::snprintf(line, sizeof(line), "\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                buffer->tid, e.begin / 1000.0, (e.end - e.begin) / 1000.0);
+            out << line;
+        }
+    }
+
+    out << "\n]}\n";
+
+    if (!out) {
+        error = "błąd zapisu do '" + path + "'";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,252 @@
+#include "Simulation.hpp"
+#include "SimulationConfig.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef SOCIALEVO_BENCH_RENDERER
+#include "SimulationRenderer.hpp"
+#endif
+
+// Benchmarki potoku pokolenia: reset, playOneRound, step (oba tryby), recordMetrics
+// i (w buildzie z GUI) SimulationRenderer::draw. Macierz: rozmiary × sąsiedztwa × brzegi × wątki.
+// Wynik w JSON (cells/s, generations/s), do śledzenia regresji i doboru sprzętu.
+
+namespace {
+
+    struct BenchOptions {
+        std::vector<int> sizes = { 64, 256, 1024, 4096 };
+        std::vector<std::string> neighborhoods = { "moore", "vonneumann" };
+        std::vector<std::string> boundaries = { "periodic", "fixed", "reflective", "absorbing" };
+        std::vector<int> threads;
+        double minTime = 0.5;   // minimalny czas pomiaru [s]
+        int minIterations = 3;
+        uint64_t seed = 1;
+        std::string output = "bench.json";
+    };
+
+    struct Measurement {
+        std::string name;
+        std::string neighborhood, boundary;
+        int width = 0, height = 0, threads = 0;
+        int iterations = 0;
+        double seconds = 0.0;
+        double generationsPerIteration = 0.0; // 1 dla step, 1/K dla rundy, 0 gdy nie dotyczy
+    };
+
+    std::vector<std::string> splitList(const std::string& text) {
+        std::vector<std::string> out;
+        size_t pos = 0;
+        while (pos <= text.size()) {
+            size_t comma = text.find(',', pos);
+            if (comma == std::string::npos) comma = text.size();
+            if (comma > pos) out.push_back(text.substr(pos, comma - pos));
+            pos = comma + 1;
+        }
+        return out;
+    }
+
+    template <class T>
+    bool parseNumber(const std::string& text, T& out) {
+        auto res = std::from_chars(text.data(), text.data() + text.size(), out);
+        return res.ec == std::errc() && res.ptr == text.data() + text.size();
+    }
+
+    bool parseIntList(const std::string& text, std::vector<int>& out) {
+        out.clear();
+        for (const std::string& item : splitList(text)) {
+            int v;
+            if (!parseNumber(item, v) || v <= 0) return false;
+            out.push_back(v);
+        }
+        return !out.empty();
+    }
+
+    // Powtarza fn aż minie minTime i zrobi co najmniej minIterations wywołań
+    void measure(const BenchOptions& opt, Measurement& m, const std::function<void()>& fn) {
+        using clock = std::chrono::steady_clock;
+        const auto start = clock::now();
+        double elapsed = 0.0;
+        int iterations = 0;
+        while (iterations < opt.minIterations || elapsed < opt.minTime) {
+            fn();
+            iterations++;
+            elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        }
+        m.iterations = iterations;
+        m.seconds = elapsed;
+    }
+
+    void writeJson(std::ostream& out, const std::vector<Measurement>& results) {
+        out << "{\n";
+        out << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+#if defined(__AVX2__)
+        out << "  \"kernel\": \"avx2\",\n";
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        out << "  \"kernel\": \"sse2\",\n";
+#else
+        out << "  \"kernel\": \"scalar\",\n";
+#endif
+        out << "  \"benchmarks\": [\n";
+
+        char buf[512];
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Measurement& m = results[i];
+            const double perIter = m.seconds / m.iterations;
+            const double cells = (double)m.width * m.height;
+            const double gensPerSec = m.generationsPerIteration > 0.0 ? m.generationsPerIteration / perIter : 0.0;
+
+            std::snprintf(buf, sizeof(buf),
+                "    {\"name\": \"%s\", \"width\": %d, \"height\": %d, \"neighborhood\": \"%s\", \"boundary\": \"%s\", "
+                "\"threads\": %d, \"iterations\": %d, \"seconds\": %.6f, \"seconds_per_iteration\": %.9f, "
+                "\"cells_per_second\": %.6e, \"generations_per_second\": %.6f}%s\n",
+                m.name.c_str(), m.width, m.height, m.neighborhood.c_str(), m.boundary.c_str(),
+                m.threads, m.iterations, m.seconds, perIter, cells / perIter, gensPerSec,
+                (i + 1 < results.size()) ? "," : "");
+            out << buf;
+        }
+        out << "  ]\n}\n";
+    }
+
+    void printUsage(const char* exe) {
+        std::printf(
+            "Użycie: %s [--klucz wartość]...\n\n"
+            "  sizes                 boki siatki, np. 64,256,1024,4096\n"
+            "  neighborhoods         moore,vonneumann\n"
+            "  boundaries            periodic,fixed,reflective,absorbing\n"
+            "  threads               liczby wątków OpenMP, np. 1,4,8 (domyślnie 1 i wszystkie)\n"
+            "  min_time              minimalny czas pomiaru w sekundach (domyślnie 0.5)\n"
+            "  min_iterations        minimalna liczba powtórzeń (domyślnie 3)\n"
+            "  seed                  ziarno (domyślnie 1)\n"
+            "  output                plik JSON (domyślnie bench.json)\n",
+            exe);
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opt;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (arg.rfind("--", 0) != 0 || i + 1 >= argc) {
+            std::fprintf(stderr, "Błąd: oczekiwano '--klucz wartość', dostałem '%s' (--help)\n", arg.c_str());
+            return 2;
+        }
+
+        std::string key = arg.substr(2);
+        std::string value = argv[++i];
+        bool ok = true;
+
+        if (key == "sizes") ok = parseIntList(value, opt.sizes);
+        else if (key == "threads") ok = parseIntList(value, opt.threads);
+        else if (key == "neighborhoods") opt.neighborhoods = splitList(value);
+        else if (key == "boundaries") opt.boundaries = splitList(value);
+        else if (key == "min_time") ok = parseNumber(value, opt.minTime) && opt.minTime >= 0.0;
+        else if (key == "min_iterations") ok = parseNumber(value, opt.minIterations) && opt.minIterations >= 1;
+        else if (key == "seed") ok = parseNumber(value, opt.seed);
+        else if (key == "output") opt.output = value;
+        else {
+            std::fprintf(stderr, "Błąd: nieznany parametr '%s'\n", key.c_str());
+            return 2;
+        }
+
+        if (!ok) {
+            std::fprintf(stderr, "Błąd: zła wartość dla '%s': '%s'\n", key.c_str(), value.c_str());
+            return 2;
+        }
+    }
+
+    if (opt.threads.empty()) {
+        int all = (int)std::max(1u, std::thread::hardware_concurrency());
+        opt.threads = { 1 };
+        if (all > 1) opt.threads.push_back(all);
+    }
+
+    std::vector<Measurement> results;
+    std::string error;
+
+    for (int size : opt.sizes) {
+        for (const std::string& neighborhood : opt.neighborhoods) {
+            for (const std::string& boundary : opt.boundaries) {
+                for (int threads : opt.threads) {
+#ifdef _OPENMP
+                    omp_set_num_threads(threads);
+#endif
+                    Simulation sim(size, size, { 3.0f, 5.0f, 0.0f, 1.0f });
+                    sim.seed = opt.seed;
+                    if (!SimulationConfig::apply(sim, "neighborhood", neighborhood, error) ||
+                        !SimulationConfig::apply(sim, "boundary", boundary, error)) {
+                        std::fprintf(stderr, "Błąd: %s\n", error.c_str());
+                        return 2;
+                    }
+
+                    Measurement base;
+                    base.neighborhood = neighborhood;
+                    base.boundary = boundary;
+                    base.width = size;
+                    base.height = size;
+                    base.threads = threads;
+
+                    auto run = [&](const char* name, double gensPerIteration, const std::function<void()>& fn) {
+                        Measurement m = base;
+                        m.name = name;
+                        m.generationsPerIteration = gensPerIteration;
+                        measure(opt, m, fn);
+                        std::fprintf(stderr, "%-20s %5dx%-5d %-10s %-10s t=%-3d %12.6f s/iter\n", name, size, size,
+                            neighborhood.c_str(), boundary.c_str(), threads, m.seconds / m.iterations);
+                        results.push_back(m);
+                    };
+
+                    run("reset", 0.0, [&] { sim.reset(); });
+
+                    sim.reset();
+                    sim.step(); // rozgrzewka: pamięć relacji i bufory w stanie ustalonym
+                    run("playOneRound", 1.0 / sim.roundsPerGeneration, [&] { sim.playOneRound(); });
+
+                    sim.mode = EvolutionMode::Imitation;
+                    run("step_imitation", 1.0, [&] { sim.step(); });
+
+                    sim.reset();
+                    sim.mode = EvolutionMode::DeathBirth;
+                    run("step_deathbirth", 1.0, [&] { sim.step(); });
+
+                    run("recordMetrics", 0.0, [&] { sim.recordMetrics(); });
+
+#ifdef SOCIALEVO_BENCH_RENDERER
+                    sf::RenderTexture target;
+                    if (target.resize({ (unsigned)LEFT_PANEL_WIDTH, (unsigned)WINDOW_HEIGHT })) {
+                        SimulationSnapshot snapshot;
+                        snapshot.capture(sim);
+                        SimulationRenderer renderer;
+                        // pełna przebudowa piramidy i obrazu za każdym razem (bez poprawek przyrostowych)
+                        run("renderer_draw", 0.0, [&] { renderer.invalidate(); renderer.draw(target, snapshot); target.display(); });
+                    }
+#endif
+                }
+            }
+        }
+    }
+
+    std::ofstream f(opt.output, std::ios::trunc);
+    if (!f) {
+        std::fprintf(stderr, "Błąd: nie można zapisać '%s'\n", opt.output.c_str());
+        return 1;
+    }
+    writeJson(f, results);
+    std::fprintf(stderr, "%zu pomiarów -> %s\n", results.size(), opt.output.c_str());
+    return 0;
+}
@@ -0,0 +1,199 @@
+#include "Simulation.hpp"
+#include "Checkpoint.hpp"
+#include "SimulationConfig.hpp"
+#include "Trace.hpp"
+#include "constants.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Wsadowe uruchomienie modelu bez okna i bez ImGui (np. na węzłach obliczeniowych).
+// Parametry z pliku (--config) i/lub z linii poleceń (--klucz wartość); linia poleceń wygrywa.
+
+namespace {
+
+    struct RunOptions {
+        int generations = 1000;
+        std::string output = "metrics.csv";
+        int progressEvery = 0; // 0 = bez postępu na stderr
+        std::string trace;     // plik Chrome trace JSON (puste = bez śladu)
+        std::string checkpoint;  // plik punktu kontrolnego (puste = bez zapisu)
+        int checkpointEvery = 0; // co ile pokoleń zapisywać punkt (0 = tylko na końcu)
+        bool resumed = false;    // stan wczytany z --resume zamiast reset()
+    };
+
+    void printUsage(const char* exe) {
+        std::printf(
+            "Użycie: %s [--config plik] [--klucz wartość]...\n\n"
+            "Uruchomienie:\n"
+            "  generations           numer pokolenia, na którym kończymy (domyślnie 1000; po resume liczony dalej)\n"
+            "  output                plik CSV z metrykami (domyślnie metrics.csv)\n"
+            "  progress              co ile pokoleń wypisać postęp na stderr (0 = nigdy)\n"
+            "  trace                 plik śladu Chrome trace JSON (fazy i wątki, do Perfetto)\n"
+            "  checkpoint            plik punktu kontrolnego zapisywany na końcu (i co checkpoint_every)\n"
+            "  checkpoint_every      co ile pokoleń zapisać punkt kontrolny (0 = tylko na końcu)\n"
+            "  resume                wczytaj stan z punktu kontrolnego; klucze podane po nim zmieniają parametry\n\n"
+            "Symulacja:\n%s",
+            exe, SimulationConfig::describeKeys().c_str());
+    }
+
+    // Klucze uruchomienia obsługujemy sami, resztę przekazujemy do symulacji
+    bool applyEntry(Simulation& sim, RunOptions& run, const std::string& key, const std::string& value, std::string& error) {
+        if (key == "generations" || key == "progress" || key == "checkpoint_every") {
+            int& field = (key == "generations") ? run.generations : (key == "progress") ? run.progressEvery : run.checkpointEvery;
+            int v = 0;
+            auto res = std::from_chars(value.data(), value.data() + value.size(), v);
+            if (res.ec != std::errc() || res.ptr != value.data() + value.size() || v < 0) {
+                error = "zła wartość dla '" + key + "': '" + value + "'";
+                return false;
+            }
+            field = v;
+            return true;
+        }
+        if (key == "output" || key == "trace" || key == "checkpoint") {
+            (key == "output" ? run.output : key == "trace" ? run.trace : run.checkpoint) = value;
+            return true;
+        }
+        if (key == "resume") {
+            if (!Checkpoint::load(sim, value, error)) return false;
+            run.resumed = true;
+            return true;
+        }
+        return SimulationConfig::apply(sim, key, value, error);
+    }
+}
+
+int main(int argc, char** argv) {
+    Simulation sim(GRID_WIDTH, GRID_HEIGHT, { 3.0f, 5.0f, 0.0f, 1.0f });
+    RunOptions run;
+    std::string error;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        }
+
+        if (arg.rfind("--", 0) != 0 || i + 1 >= argc) {
+            std::fprintf(stderr, "Błąd: oczekiwano '--klucz wartość', dostałem '%s' (--help)\n", arg.c_str());
+            return 2;
+        }
+
+        std::string key = arg.substr(2);
+        std::string value = argv[++i];
+
+        if (key == "config") {
+            SimulationConfig::Entries entries;
+            if (!SimulationConfig::loadFile(value, entries, error)) {
+                std::fprintf(stderr, "Błąd: %s\n", error.c_str());
+                return 2;
+            }
+            for (const auto& [k, v] : entries) {
+                if (!applyEntry(sim, run, k, v, error)) {
+                    std::fprintf(stderr, "Błąd (%s): %s\n", value.c_str(), error.c_str());
+                    return 2;
+                }
+            }
+            continue;
+        }
+
+        if (!applyEntry(sim, run, key, value, error)) {
+            std::fprintf(stderr, "Błąd: %s\n", error.c_str());
+            return 2;
+        }
+    }
+
+    if (run.checkpointEvery > 0 && run.checkpoint.empty()) run.checkpoint = Checkpoint::DEFAULT_PATH;
+
+    sim.exportCsvEnabled = !run.output.empty();
+    sim.exportPath = run.output;
+
+    if (run.resumed) {
+        // Wczytany stan ma już populację; nowa wymagałaby reset(), który by go skasował
+        if (sim.agents.size() != sim.grid.cellCount()) {
+            std::fprintf(stderr, "Błąd: po resume nie można zmienić wymiarów siatki\n");
+            return 2;
+        }
+        if (sim.exportCsvEnabled && !sim.continueCsvFile(error)) {
+            std::fprintf(stderr, "Błąd: %s\n", error.c_str());
+            return 2;
+        }
+    }
+    else {
+        if (sim.exportCsvEnabled) sim.newCsvFile();
+
+        // reset() zapisuje też próbkę pokolenia 0
+        sim.reset();
+        sim.exportMetricsRowIfNeeded();
+    }
+
+    const int firstGeneration = sim.generation;
+    const int generationsToRun = std::max(0, run.generations - firstGeneration);
+
+    std::fprintf(stderr, "Siatka %dx%d, seed %llu, pokolenia %d..%d -> %s\n", sim.grid.width, sim.grid.height,
+        (unsigned long long)sim.seed, firstGeneration, std::max(firstGeneration, run.generations),
+        run.output.empty() ? "(bez zapisu)" : run.output.c_str());
+
+    auto saveCheckpoint = [&]() {
+        // CSV najpierw, żeby po awarii plik sięgał co najmniej do pokolenia z punktu
+        if (!sim.flushCsvFile()) {
+            std::fprintf(stderr, "Błąd zapisu %s\n", run.output.c_str());
+            return false;
+        }
+        if (!Checkpoint::save(sim, run.checkpoint, error)) {
+            std::fprintf(stderr, "Błąd punktu kontrolnego: %s\n", error.c_str());
+            return false;
+        }
+        return true;
+    };
+
+    if (!run.trace.empty()) {
+        Trace::setThreadName("main");
+        Trace::start();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    while (sim.generation < run.generations) {
+        sim.step();
+
+        if (run.progressEvery > 0 && sim.generation % run.progressEvery == 0) {
+            std::fprintf(stderr, "pokolenie %d/%d, kooperacja %.4f\n", sim.generation, run.generations, sim.lastMetrics.coopRatio);
+        }
+
+        if (run.checkpointEvery > 0 && sim.generation % run.checkpointEvery == 0 && sim.generation < run.generations) {
+            if (!saveCheckpoint()) return 1;
+        }
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!run.trace.empty()) {
+        Trace::stop();
+        if (!Trace::writeChromeJson(run.trace, error)) {
+            std::fprintf(stderr, "Błąd: %s\n", error.c_str());
+            return 1;
+        }
+        std::fprintf(stderr, "Ślad: %zu zdarzeń -> %s", Trace::eventCount(), run.trace.c_str());
+        if (Trace::droppedCount() > 0) std::fprintf(stderr, " (odrzucono %zu, bufory pełne)", Trace::droppedCount());
+        std::fprintf(stderr, "\n");
+    }
+
+    if (!sim.flushCsvFile()) {
+        std::fprintf(stderr, "Błąd zapisu %s\n", run.output.c_str());
+        return 1;
+    }
+
+    if (!run.checkpoint.empty() && !saveCheckpoint()) return 1;
+
+    const double cellGenerations = (double)sim.grid.cellCount() * generationsToRun;
+
+    std::printf("generations=%d seconds=%.3f gens_per_sec=%.2f cells_per_sec=%.3e alive=%d coop_ratio=%.6f\n",
+        generationsToRun, seconds, seconds > 0.0 ? generationsToRun / seconds : 0.0,
+        seconds > 0.0 ? cellGenerations / seconds : 0.0, sim.lastMetrics.alive, sim.lastMetrics.coopRatio);
+    return 0;
+}
@@ -0,0 +1,249 @@
+#include "MetricsLog.hpp"
+#include <charconv>
+#include <climits>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Narzędzie do binarnego logu metryk (export_format = binary): konwersja do CSV, wycinanie
+// zakresu pokoleń i podgląd nagłówka. Czyta blok po bloku, bloki spoza zakresu pomija
+// bez dekodowania; niedokończony ostatni blok trwającego przebiegu jest ignorowany.
+// Kolejne przebiegi w jednym pliku (segmenty) dostają w CSV własny wiersz nagłówka, tak jak
+// w bezpośrednim eksporcie CSV po resecie.
+
+namespace {
+
+    struct LogOptions {
+        std::string input;
+        std::string output;        // puste = stdout
+        int from = INT_MIN;
+        int to = INT_MAX;
+        std::vector<std::string> columns; // puste = wszystkie
+        bool info = false;
+    };
+
+    void printUsage(const char* exe) {
+        std::printf(
+            "Użycie: %s plik.mlog [--klucz wartość]... [--info]\n\n"
+            "  from                  pierwsze pokolenie (domyślnie od początku)\n"
+            "  to                    ostatnie pokolenie (domyślnie do końca)\n"
+            "  columns               lista kolumn po przecinku (domyślnie wszystkie)\n"
+            "  output                plik CSV (domyślnie standardowe wyjście)\n"
+            "  --info                schemat, parametry przebiegu i bloki zamiast danych\n",
+            exe);
+    }
+
+    bool parseInt(const std::string& text, int& out) {
+        auto res = std::from_chars(text.data(), text.data() + text.size(), out);
+        return res.ec == std::errc() && res.ptr == text.data() + text.size();
+    }
+
+    std::vector<std::string> splitList(const std::string& text) {
+        std::vector<std::string> out;
+        size_t pos = 0;
+        while (pos <= text.size()) {
+            size_t comma = text.find(',', pos);
+            if (comma == std::string::npos) comma = text.size();
+            if (comma > pos) out.push_back(text.substr(pos, comma - pos));
+            pos = comma + 1;
+        }
+        return out;
+    }
+
+    void printHeader(const MetricsLog::Header& h) {
+        std::printf("# kolumny (%zu), %s\n", h.columns.size(), h.compressed ? "bloki skompresowane" : "bloki bez kompresji");
+        for (const auto& c : h.columns) {
+            const char* type = c.type == MetricsLog::ColumnType::Int32 ? "int32" : c.type == MetricsLog::ColumnType::Float32 ? "float32" : "float64";
+            std::printf("#   %-20s %s\n", c.name.c_str(), type);
+        }
+
+        // Parametry w formacie pliku konfiguracyjnego (można podać jako --config)
+        std::printf("\n");
+        for (const auto& [key, value] : h.params) std::printf("%s = %s\n", key.c_str(), value.c_str());
+    }
+
+    void printSegmentSummary(int blocks, long long rows, int first, int last) {
+        std::printf("\n# bloki: %d, wiersze: %lld, pokolenia: %d..%d\n", blocks, rows, first, last);
+    }
+
+    int printInfo(MetricsLog::Reader& reader) {
+        printHeader(reader.header());
+
+        MetricsLog::Reader::Block block;
+        std::string error;
+        long long rows = 0;
+        int blocks = 0, first = 0, last = 0, segment = 0;
+        while (reader.nextBlock(block, error)) {
+            if (block.segment != segment) {
+                printSegmentSummary(blocks, rows, first, last);
+                std::printf("\n# --- przebieg %d (kolejny nagłówek w pliku) ---\n", block.segment + 1);
+                printHeader(reader.header());
+                segment = block.segment;
+                rows = 0;
+                blocks = 0;
+            }
+            if (blocks == 0) first = block.firstGeneration;
+            last = block.lastGeneration;
+            rows += block.rows;
+            blocks++;
+        }
+        printSegmentSummary(blocks, rows, first, last);
+
+        if (!error.empty()) {
+            std::fprintf(stderr, "Błąd: %s\n", error.c_str());
+            return 1;
+        }
+        return 0;
+    }
+
+    // Indeksy wybranych kolumn w schemacie segmentu; false, gdy którejś brakuje
+    bool selectColumns(const std::vector<MetricsLog::Column>& schema, const std::vector<std::string>& names, std::vector<size_t>& selected) {
+        selected.clear();
+        if (names.empty()) {
+            for (size_t c = 0; c < schema.size(); ++c) selected.push_back(c);
+        }
+        for (const std::string& name : names) {
+            size_t c = 0;
+            while (c < schema.size() && schema[c].name != name) c++;
+            if (c == schema.size()) {
+                std::fprintf(stderr, "Błąd: brak kolumny '%s'\n", name.c_str());
+                return false;
+            }
+            selected.push_back(c);
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    LogOptions opt;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (arg == "--info") {
+            opt.info = true;
+            continue;
+        }
+        if (arg.rfind("--", 0) != 0) {
+            if (!opt.input.empty()) {
+                std::fprintf(stderr, "Błąd: podano dwa pliki wejściowe ('%s')\n", arg.c_str());
+                return 2;
+            }
+            opt.input = arg;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::fprintf(stderr, "Błąd: brak wartości dla '%s' (--help)\n", arg.c_str());
+            return 2;
+        }
+
+        const std::string key = arg.substr(2);
+        const std::string value = argv[++i];
+        bool ok = true;
+        if (key == "from") ok = parseInt(value, opt.from);
+        else if (key == "to") ok = parseInt(value, opt.to);
+        else if (key == "columns") opt.columns = splitList(value);
+        else if (key == "output") opt.output = value;
+        else ok = false;
+
+        if (!ok) {
+            std::fprintf(stderr, "Błąd: zły parametr '%s %s' (--help)\n", arg.c_str(), value.c_str());
+            return 2;
+        }
+    }
+
+    if (opt.input.empty()) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::string error;
+    MetricsLog::Reader reader;
+    if (!reader.open(opt.input, error)) {
+        std::fprintf(stderr, "Błąd: %s\n", error.c_str());
+        return 1;
+    }
+
+    if (opt.info) return printInfo(reader);
+
+    // Wybrane kolumny (indeksy w schemacie pierwszego segmentu; kolejne wybierane od nowa)
+    std::vector<size_t> selected;
+    if (!selectColumns(reader.header().columns, opt.columns, selected)) return 2;
+
+    std::FILE* out = opt.output.empty() ? stdout : std::fopen(opt.output.c_str(), "wb");
+    if (!out) {
+        std::fprintf(stderr, "Błąd: nie można utworzyć '%s'\n", opt.output.c_str());
+        return 1;
+    }
+
+    const auto writeHeaderLine = [&] {
+        const auto& schema = reader.header().columns;
+        for (size_t i = 0; i < selected.size(); ++i) {
+            std::fprintf(out, "%s%s", i ? "," : "", schema[selected[i]].name.c_str());
+        }
+        std::fputc('\n', out);
+    };
+    writeHeaderLine();
+
+    // Wiersz jak w eksporcie CSV symulacji (te same formaty liczb)
+    std::vector<std::vector<uint64_t>> columns;
+    std::vector<char> line;
+    MetricsLog::Reader::Block block;
+    long long written = 0;
+    int segment = 0;
+    bool segmentHeaderDue = false;
+
+    while (reader.nextBlock(block, error)) {
+        if (block.segment != segment) {
+            segment = block.segment;
+            if (!selectColumns(reader.header().columns, opt.columns, selected)) return 1;
+            segmentHeaderDue = true; // dopiero przed pierwszym wierszem segmentu z zakresu
+        }
+        if (block.lastGeneration < opt.from || block.firstGeneration > opt.to) {
+            reader.skipBlock();
+            continue;
+        }
+        if (!reader.readBlock(columns, error)) {
+            std::fprintf(stderr, "Błąd: %s\n", error.c_str());
+            return 1;
+        }
+
+        const auto& schema = reader.header().columns;
+        line.resize(selected.size() * 40 + 2);
+        for (int r = 0; r < block.rows; ++r) {
+            const int generation = (int32_t)(uint32_t)columns[0][(size_t)r];
+            if (generation < opt.from || generation > opt.to) continue;
+
+            if (segmentHeaderDue) {
+                writeHeaderLine();
+                segmentHeaderDue = false;
+            }
+
+            char* p = line.data();
+            for (size_t i = 0; i < selected.size(); ++i) {
+                if (i) *p++ = ',';
+                p = MetricsLog::Reader::formatValue(p, schema[selected[i]].type, columns[selected[i]][(size_t)r]);
+            }
+            *p++ = '\n';
+            std::fwrite(line.data(), 1, (size_t)(p - line.data()), out);
+            written++;
+        }
+    }
+
+    if (!error.empty()) {
+        std::fprintf(stderr, "Błąd: %s\n", error.c_str());
+        if (out != stdout) std::fclose(out);
+        return 1;
+    }
+
+    if (out != stdout) {
+        std::fclose(out);
+        std::fprintf(stderr, "%lld wierszy -> %s\n", written, opt.output.c_str());
+    }
+    return 0;
+}
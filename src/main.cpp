@@ -1,9 +1,13 @@
+#ifdef _WIN32
 #define NOMINMAX
 #include <Windows.h>
+#endif
 #include "SimulationApp.hpp"
 
 int main() {
+#ifdef _WIN32
     SetProcessDPIAware();
+#endif
     SimulationApp app;
     app.run();
     return 0;
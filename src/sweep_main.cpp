@@ -0,0 +1,159 @@
+#include "ParameterSweep.hpp"
+#include "SimulationConfig.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+
+// Sweep parametrów bez GUI: osie "sweep.<klucz> = start:stop:krok" albo "a,b,c",
+// wspólne ustawienia jak w social-evolution-cli. Wynik: jedna linia CSV na zadanie.
+
+namespace {
+
+    struct SweepOptions {
+        int generations = 1000;
+        int replicates = 1;
+        int threads = 0; // 0 = wszystkie rdzenie
+        uint64_t seed = 0;
+        bool seedGiven = false;
+        std::string output = "sweep.csv";
+    };
+
+    void printUsage(const char* exe) {
+        std::printf(
+            "Użycie: %s [--config plik] [--klucz wartość]...\n\n"
+            "Sweep:\n"
+            "  sweep.<klucz>         oś parametru: start:stop:krok albo lista a,b,c\n"
+            "  replicates            replikacje na punkt (domyślnie 1)\n"
+            "  generations           pokolenia na zadanie (domyślnie 1000)\n"
+            "  threads               równoległe instancje (domyślnie liczba rdzeni)\n"
+            "  seed                  ziarno bazowe replikacji (domyślnie losowe)\n"
+            "  output                plik CSV z wynikami (domyślnie sweep.csv)\n\n"
+            "Wspólne parametry symulacji:\n%s",
+            exe, SimulationConfig::describeKeys().c_str());
+    }
+
+    template <class T>
+    bool parseNumber(const std::string& text, T& out) {
+        auto res = std::from_chars(text.data(), text.data() + text.size(), out);
+        return res.ec == std::errc() && res.ptr == text.data() + text.size();
+    }
+
+    bool applyEntry(SweepOptions& opt, std::vector<SweepAxis>& axes, SimulationConfig::Entries& base,
+        const std::string& key, const std::string& value, std::string& error) {
+
+        if (key.rfind("sweep.", 0) == 0) {
+            SweepAxis axis;
+            if (!ParameterSweep::parseAxis(key.substr(6), value, axis, error)) return false;
+            axes.push_back(std::move(axis));
+            return true;
+        }
+
+        bool ok = true;
+        if (key == "generations") ok = parseNumber(value, opt.generations) && opt.generations >= 0;
+        else if (key == "replicates") ok = parseNumber(value, opt.replicates) && opt.replicates >= 1;
+        else if (key == "threads") ok = parseNumber(value, opt.threads) && opt.threads >= 0;
+        else if (key == "seed") ok = opt.seedGiven = parseNumber(value, opt.seed);
+        else if (key == "output") opt.output = value;
+        else {
+            // Walidacja od razu na próbnej symulacji, żeby błąd wyszedł przed startem puli
+            Simulation probe(1, 1, { 3.0f, 5.0f, 0.0f, 1.0f });
+            if (!SimulationConfig::apply(probe, key, value, error)) return false;
+            base.emplace_back(key, value);
+        }
+
+        if (!ok) error = "zła wartość dla '" + key + "': '" + value + "'";
+        return ok;
+    }
+}
+
+int main(int argc, char** argv) {
+    SweepOptions opt;
+    std::vector<SweepAxis> axes;
+    SimulationConfig::Entries base;
+    std::string error;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        }
+
+        if (arg.rfind("--", 0) != 0 || i + 1 >= argc) {
+            std::fprintf(stderr, "Błąd: oczekiwano '--klucz wartość', dostałem '%s' (--help)\n", arg.c_str());
+            return 2;
+        }
+
+        std::string key = arg.substr(2);
+        std::string value = argv[++i];
+
+        if (key == "config") {
+            SimulationConfig::Entries entries;
+            if (!SimulationConfig::loadFile(value, entries, error)) {
+                std::fprintf(stderr, "Błąd: %s\n", error.c_str());
+                return 2;
+            }
+            for (const auto& [k, v] : entries) {
+                if (!applyEntry(opt, axes, base, k, v, error)) {
+                    std::fprintf(stderr, "Błąd (%s): %s\n", value.c_str(), error.c_str());
+                    return 2;
+                }
+            }
+            continue;
+        }
+
+        if (!applyEntry(opt, axes, base, key, value, error)) {
+            std::fprintf(stderr, "Błąd: %s\n", error.c_str());
+            return 2;
+        }
+    }
+
+    // Sprawdzenie wartości osi, zanim cokolwiek ruszy
+    for (const SweepAxis& axis : axes) {
+        Simulation probe(1, 1, { 3.0f, 5.0f, 0.0f, 1.0f });
+        for (const std::string& v : axis.values) {
+            if (!SimulationConfig::apply(probe, axis.key, v, error)) {
+                std::fprintf(stderr, "Błąd (sweep.%s): %s\n", axis.key.c_str(), error.c_str());
+                return 2;
+            }
+        }
+    }
+
+    if (!opt.seedGiven) {
+        std::random_device rd;
+        opt.seed = ((uint64_t)rd() << 32) | rd();
+    }
+    if (opt.threads == 0) opt.threads = (int)std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<SweepJob> jobs = ParameterSweep::expand(axes, opt.replicates, opt.seed);
+
+    std::fprintf(stderr, "%zu zadań (%zu osi, %d replikacji), %d wątków, seed bazowy %llu -> %s\n",
+        jobs.size(), axes.size(), opt.replicates, opt.threads, (unsigned long long)opt.seed, opt.output.c_str());
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<SweepResult> results = ParameterSweep::run(base, jobs, opt.generations, opt.threads,
+        [&](const SweepResult& r, size_t done) {
+            if (!r.ok) std::fprintf(stderr, "zadanie %d/%d: %s\n", r.job.point, r.job.replicate, r.error.c_str());
+            std::fprintf(stderr, "\r%zu/%zu", done, jobs.size());
+        });
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "\n");
+
+    std::ofstream f(opt.output, std::ios::trunc);
+    if (!f) {
+        std::fprintf(stderr, "Błąd: nie można zapisać '%s'\n", opt.output.c_str());
+        return 1;
+    }
+    ParameterSweep::writeCsv(f, axes, results);
+
+    std::printf("jobs=%zu seconds=%.3f jobs_per_sec=%.3f\n", jobs.size(), seconds, seconds > 0.0 ? jobs.size() / seconds : 0.0);
+    return 0;
+}